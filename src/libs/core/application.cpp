@@ -67,6 +67,7 @@ Application::Application(quint16 httpServerPort, QObject *parent)
     m_extractorThread->start();
 
     m_docsetRegistry = new Registry::DocsetRegistry(m_httpServer);
+    m_docsetRegistry->setCachePath(cacheLocation());
 
     connect(m_settings, &Settings::updated, this, &Application::applySettings);
     applySettings();
@@ -233,7 +234,15 @@ void Application::checkForUpdates(bool quiet)
 void Application::applySettings()
 {
     m_docsetRegistry->setFuzzySearchEnabled(m_settings->isFuzzySearchEnabled);
+    m_docsetRegistry->setSymbolIndexEnabled(m_settings->isSymbolIndexEnabled);
+    m_docsetRegistry->setTrigramIndexEnabled(m_settings->isTrigramIndexEnabled);
+    m_docsetRegistry->setMaxResults(m_settings->maxSearchResults);
+    m_docsetRegistry->setProgressiveSearchEnabled(m_settings->isProgressiveSearchEnabled);
+    m_docsetRegistry->setSearchThreadCount(m_settings->searchThreadCount);
+    m_docsetRegistry->setSearchThreadPriority(m_settings->isLowPrioritySearchEnabled ? QThread::LowPriority
+                                                                                     : QThread::InheritPriority);
     m_docsetRegistry->setStoragePath(m_settings->docsetPath);
+    m_docsetRegistry->setStorageWatchEnabled(m_settings->isDocsetStorageWatchEnabled);
 
     // HTTP Proxy Settings
     switch (m_settings->proxyType) {
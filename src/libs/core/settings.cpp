@@ -157,6 +157,12 @@ void Settings::load()
 
     settings->beginGroup(GroupSearch);
     isFuzzySearchEnabled = settings->value(QStringLiteral("fuzzy_search_enabled"), true).toBool();
+    isSymbolIndexEnabled = settings->value(QStringLiteral("in_memory_index"), false).toBool();
+    isTrigramIndexEnabled = settings->value(QStringLiteral("trigram_index"), false).toBool();
+    maxSearchResults = settings->value(QStringLiteral("max_results"), 300).toInt();
+    isProgressiveSearchEnabled = settings->value(QStringLiteral("progressive"), false).toBool();
+    searchThreadCount = settings->value(QStringLiteral("thread_count"), 0).toInt();
+    isLowPrioritySearchEnabled = settings->value(QStringLiteral("low_priority"), false).toBool();
     settings->endGroup();
 
     settings->beginGroup(GroupContent);
@@ -261,6 +267,7 @@ void Settings::load()
         docsetPath = QStringLiteral("docsets");
 #endif
     }
+    isDocsetStorageWatchEnabled = settings->value(QStringLiteral("watch"), false).toBool();
     settings->endGroup();
 
     // Create the docset storage directory if it doesn't exist.
@@ -310,6 +317,12 @@ void Settings::save()
 
     settings->beginGroup(GroupSearch);
     settings->setValue(QStringLiteral("fuzzy_search_enabled"), isFuzzySearchEnabled);
+    settings->setValue(QStringLiteral("in_memory_index"), isSymbolIndexEnabled);
+    settings->setValue(QStringLiteral("trigram_index"), isTrigramIndexEnabled);
+    settings->setValue(QStringLiteral("max_results"), maxSearchResults);
+    settings->setValue(QStringLiteral("progressive"), isProgressiveSearchEnabled);
+    settings->setValue(QStringLiteral("thread_count"), searchThreadCount);
+    settings->setValue(QStringLiteral("low_priority"), isLowPrioritySearchEnabled);
     settings->endGroup();
 
     settings->beginGroup(GroupContent);
@@ -341,6 +354,7 @@ void Settings::save()
 
     settings->beginGroup(GroupDocsets);
     settings->setValue(QStringLiteral("path"), docsetPath);
+    settings->setValue(QStringLiteral("watch"), isDocsetStorageWatchEnabled);
     settings->endGroup();
 
     settings->beginGroup(GroupInternal);
@@ -45,6 +45,12 @@ public:
 
     // Search
     bool isFuzzySearchEnabled;
+    bool isSymbolIndexEnabled;
+    bool isTrigramIndexEnabled;
+    int maxSearchResults; // 0 for unlimited
+    bool isProgressiveSearchEnabled;
+    int searchThreadCount; // 0 for one per CPU core
+    bool isLowPrioritySearchEnabled;
 
     // Content
     QString defaultFontFamily;
@@ -102,6 +108,7 @@ public:
 
     // Other
     QString docsetPath;
+    bool isDocsetStorageWatchEnabled;
 
     explicit Settings(QObject *parent = nullptr);
     ~Settings() override;
@@ -4,7 +4,12 @@
 
 #include "docset.h"
 
+#include "indexbuild.h"
+#include "manifestcache.h"
+#include "nameindex.h"
 #include "searchresult.h"
+#include "symbolindex.h"
+#include "trigramindex.h"
 
 #include <util/database.h>
 #include <util/fuzzy.h>
@@ -13,17 +18,23 @@
 #include <util/tarixarchive.h>
 
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFile>
+#include <QFileInfo>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QLoggingCategory>
+#include <QMutexLocker>
 #include <QRegularExpression>
+#include <QScopeGuard>
 #include <QVarLengthArray>
 #include <QVariant>
+#include <QtConcurrent>
 
 #include <sqlite3.h>
 
+#include <algorithm>
 #include <utility>
 
 namespace Zeal::Registry {
@@ -33,13 +44,62 @@ Q_LOGGING_CATEGORY(log, "zeal.registry.docset")
 
 using Qt::Literals::StringLiterals::operator""_L1;
 
-constexpr auto IndexNamePrefix = "__zi_name"_L1; // zi - Zeal index
-constexpr auto IndexNameVersion = "0001"_L1;     // Current index version
+// The ZDash symbol tables joined into what Dash docsets have as searchIndex.
+const QString &symbolJoinQuery()
+{
+    static const QString query = QStringLiteral("  SELECT"
+                                                "    ztokenname AS name,"
+                                                "    ztypename AS type,"
+                                                "    zpath AS path,"
+                                                "    zanchor AS fragment"
+                                                "  FROM ztoken"
+                                                "  INNER JOIN ztokenmetainformation"
+                                                "    ON ztoken.zmetainformation = ztokenmetainformation.z_pk"
+                                                "  INNER JOIN zfilepath"
+                                                "    ON ztokenmetainformation.zfile = zfilepath.z_pk"
+                                                "  INNER JOIN ztokentype"
+                                                "    ON ztoken.ztokentype = ztokentype.z_pk");
+    return query;
+}
+
+// Searches read docset databases through a memory map, so that pages are not
+// copied into the page cache, which is kept a little above SQLite's default.
+constexpr qint64 DatabaseMmapSize = 256 * 1024 * 1024;
+constexpr int DatabaseCacheSize = 8 * 1024; // KiB
+// Name index builds lock the database while committing, see NameIndex.
+constexpr int DatabaseBusyTimeout = 10000; // ms
+
+// How long a connection goes without the name index after attaching it failed.
+constexpr int NameIndexRetryInterval = 30000; // ms
+// How long to wait before building a trigram index again after a failed build.
+constexpr int TrigramIndexRetryInterval = 5 * 60 * 1000; // ms
+
+// SQLite also writes its journal next to the database.
+bool isWritableDatabase(const QString &path)
+{
+    const QFileInfo fi(path);
+    return fi.isWritable() && QFileInfo(fi.absolutePath()).isWritable();
+}
 
 constexpr auto DocumentsPath = "Contents/Resources/Documents/"_L1;
 
 constexpr auto NotFoundPageUrl = "qrc:///browser/not-found.html"_L1;
 
+// Cap on results for listings and very short queries, which match almost everything.
+// TODO: Show a notification about the reduced result set.
+constexpr int ShortQueryLimit = 1000;
+constexpr int ShortQueryLength = 3;
+
+// Combines the caller's top-K limit (0 for none) with the short query cap.
+int resultLimit(const QString &query, int limit)
+{
+    if (query.size() >= ShortQueryLength) {
+        return limit;
+    }
+
+    return limit > 0 ? std::min(limit, ShortQueryLimit) : ShortQueryLimit;
+}
+
 namespace InfoPlist {
 constexpr auto CFBundleName = "CFBundleName"_L1;
 // const char CFBundleIdentifier[] = "CFBundleIdentifier";
@@ -52,16 +112,53 @@ constexpr auto DocSetPlatformFamily = "DocSetPlatformFamily"_L1;
 constexpr auto IsJavaScriptEnabled = "isJavaScriptEnabled"_L1;
 } // namespace InfoPlist
 
+// The query lowered once per statement, cached as auxiliary data on the
+// constant needle argument of zealScore().
+QString *loweredNeedle(sqlite3_context *context, sqlite3_value *value)
+{
+    auto *needle = static_cast<QString *>(sqlite3_get_auxdata(context, 0));
+    if (needle != nullptr) {
+        return needle;
+    }
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    const auto *text = reinterpret_cast<const char *>(sqlite3_value_text(value));
+    const QString query = QString::fromUtf8(text, sqlite3_value_bytes(value));
+
+    // Lowercase per UTF-16 code unit, as Util::Fuzzy does.
+    needle = new QString();
+    needle->reserve(query.size());
+    for (const QChar ch : query) {
+        needle->append(ch.toLower());
+    }
+
+    sqlite3_set_auxdata(context, 0, needle, [](void *p) {
+        delete static_cast<QString *>(p);
+    });
+
+    // SQLite may have destroyed the data already, e.g. when out of memory.
+    return static_cast<QString *>(sqlite3_get_auxdata(context, 0));
+}
+
 void sqliteScoreFunction(sqlite3_context *context, int argc, sqlite3_value **argv)
 {
     Q_UNUSED(argc)
 
     // NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic)
-    const auto *needle = reinterpret_cast<const char *>(sqlite3_value_text(argv[0]));
+    const QString *needle = loweredNeedle(context, argv[0]);
+    if (needle == nullptr) {
+        const auto *query = reinterpret_cast<const char *>(sqlite3_value_text(argv[0]));
+        const auto *haystack = reinterpret_cast<const char *>(sqlite3_value_text(argv[1]));
+        sqlite3_result_double(context, Zeal::Util::Fuzzy::scoreFunction(query, haystack));
+        return;
+    }
+
+    // Get the text before its size, so that the size is of the UTF-8 form.
     const auto *haystack = reinterpret_cast<const char *>(sqlite3_value_text(argv[1]));
+    const int size = sqlite3_value_bytes(argv[1]);
     // NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic)
 
-    sqlite3_result_double(context, Zeal::Util::Fuzzy::scoreFunction(needle, haystack));
+    sqlite3_result_double(context, Zeal::Util::Fuzzy::scoreUtf8(*needle, haystack, size));
 }
 } // namespace
 
@@ -73,12 +170,16 @@ Docset::Docset(QString path)
         return;
     }
 
+    // Taken first, so that files changed while loading do not look unchanged later.
+    m_fileStamp = ManifestCache::fileStamp(m_path);
+
     loadMetadata();
 
     // Attempt to find the icon in any supported format
     const auto iconFiles = dir.entryList({QStringLiteral("icon.*")}, QDir::Files);
     for (const QString &iconFile : iconFiles) {
-        m_icon = QIcon(dir.filePath(iconFile));
+        m_iconPath = dir.filePath(iconFile);
+        m_icon = QIcon(m_iconPath);
         if (!m_icon.availableSizes().isEmpty()) {
             break;
         }
@@ -123,60 +224,7 @@ Docset::Docset(QString path)
         m_title.replace(QLatin1Char('_'), QLatin1Char(' '));
     }
 
-    if (!dir.cd(QStringLiteral("Resources"))) {
-        qCWarning(log,
-                  "[%s] Cannot change directory into 'Resources' at '%s'.",
-                  qPrintable(m_name),
-                  qPrintable(m_path));
-        return;
-    }
-
-    if (!dir.exists(QStringLiteral("docSet.dsidx"))) {
-        qCWarning(log, "[%s] Cannot access 'docSet.dsidx' at '%s'.", qPrintable(m_name), qPrintable(m_path));
-        return;
-    }
-
-    m_db = new Util::Database(dir.filePath(QStringLiteral("docSet.dsidx")));
-
-    if (!m_db->isOpen()) {
-        qCWarning(log, "[%s] Cannot open database: %s.", qPrintable(m_name), qPrintable(m_db->lastError()));
-        return;
-    }
-
-    sqlite3_create_function(m_db->handle(),
-                            "zealScore",
-                            2,
-                            SQLITE_UTF8,
-                            nullptr,
-                            sqliteScoreFunction,
-                            nullptr,
-                            nullptr);
-
-    m_type = m_db->tables().contains(QStringLiteral("searchIndex"), Qt::CaseInsensitive) ? Type::Dash : Type::ZDash;
-
-    createIndex();
-
-    if (m_type == Docset::Type::ZDash) {
-        createView();
-    }
-
-    // Archived docsets keep documents in a tarix archive instead of a Documents directory.
-    if (dir.exists(QStringLiteral("tarix.tgz")) && dir.exists(QStringLiteral("tarixIndex.db"))) {
-        auto archive = std::make_unique<Util::TarixArchive>(dir.filePath(QStringLiteral("tarix.tgz")),
-                                                            dir.filePath(QStringLiteral("tarixIndex.db")));
-        if (!archive->isOpen()) {
-            qCWarning(log, "[%s] Cannot open tarix archive: %s.", qPrintable(m_name), qPrintable(archive->lastError()));
-            m_type = Type::Invalid;
-            return;
-        }
-
-        m_tarixArchive = std::move(archive);
-    } else if (!dir.cd(QStringLiteral("Documents"))) {
-        qCWarning(log,
-                  "[%s] Cannot change directory into 'Documents' at '%s'.",
-                  qPrintable(m_name),
-                  qPrintable(m_path));
-        m_type = Type::Invalid;
+    if (!openStorage()) {
         return;
     }
 
@@ -211,8 +259,9 @@ Docset::Docset(QString path)
     m_keywords.removeDuplicates();
 
     // Determine index page: prefer docset's plist, then metadata, then index.html.
-    const auto documentExists = [this, &dir](const QString &path) {
-        return m_tarixArchive != nullptr ? m_tarixArchive->exists(DocumentsPath + path) : dir.exists(path);
+    const QDir documentDir(documentPath());
+    const auto documentExists = [this, &documentDir](const QString &path) {
+        return m_tarixArchive != nullptr ? m_tarixArchive->exists(DocumentsPath + path) : documentDir.exists(path);
     };
 
     QString indexFilePath;
@@ -232,27 +281,76 @@ Docset::Docset(QString path)
         indexFilePath = QStringLiteral("index.html");
     }
 
-    m_indexFilePath = indexFilePath;
+    setIndexFilePath(indexFilePath);
 
-    // Log if unable to determine the index page. Otherwise the path will be set in setBaseUrl().
-    if (m_indexFilePath.isEmpty()) {
-        qCInfo(log, "[%s] Cannot determine index file.", qPrintable(m_name));
-        m_indexFileUrl.setUrl(NotFoundPageUrl);
-    } else {
-        m_indexFileUrl = createPageUrl(m_indexFilePath);
+    m_isValid = true;
+}
+
+Docset::Docset(QString path, const ManifestEntry &entry)
+    : m_name(entry.name)
+    , m_title(entry.title)
+    , m_keywords(entry.keywords)
+    , m_version(entry.version)
+    , m_revision(entry.revision)
+    , m_feedUrl(entry.feedUrl)
+    , m_path(std::move(path))
+    , m_fileStamp(entry.fileStamp)
+    , m_iconPath(entry.iconPath)
+    , m_hasSymbolCounts(entry.hasSymbolCounts)
+    , m_symbolStrings(entry.symbolStrings)
+    , m_symbolCounts(entry.symbolCounts)
+    , m_isJavaScriptEnabled(entry.isJavaScriptEnabled)
+{
+    if (!m_iconPath.isEmpty()) {
+        m_icon = QIcon(m_iconPath);
     }
 
-    countSymbols();
+    if (!openStorage()) {
+        return;
+    }
+
+    setIndexFilePath(entry.indexFilePath);
+
+    m_isValid = true;
 }
 
 Docset::~Docset()
 {
-    delete m_db;
+    // The symbol index build reads members, see buildSymbolIndex().
+    m_isSymbolIndexBuildCanceled.store(true, std::memory_order_relaxed);
+    m_symbolIndexBuildFuture.waitForFinished();
+}
+
+Docset::ManifestEntry Docset::manifestEntry() const
+{
+    ManifestEntry entry{.name = m_name,
+                        .title = m_title,
+                        .keywords = m_keywords,
+                        .version = m_version,
+                        .revision = m_revision,
+                        .feedUrl = m_feedUrl,
+                        .iconPath = m_iconPath,
+                        .indexFilePath = m_indexFilePath,
+                        .isJavaScriptEnabled = m_isJavaScriptEnabled,
+                        .fileStamp = fileStamp()};
+
+    const QMutexLocker locker(&m_symbolCountsMutex);
+    entry.hasSymbolCounts = m_hasSymbolCounts;
+    entry.symbolStrings = m_symbolStrings;
+    entry.symbolCounts = m_symbolCounts;
+
+    return entry;
+}
+
+QList<qint64> Docset::fileStamp() const
+{
+    const QMutexLocker locker(&m_fileStampMutex);
+    return m_fileStamp;
 }
 
 bool Docset::isValid() const
 {
-    return m_type != Type::Invalid;
+    return m_isValid && !m_hasDatabaseError.load(std::memory_order_relaxed);
 }
 
 QString Docset::name() const
@@ -347,113 +445,161 @@ QUrl Docset::indexFileUrl() const
     return m_indexFileUrl;
 }
 
+qint64 Docset::databaseSize() const
+{
+    return m_databaseSize;
+}
+
 QMap<QString, int> Docset::symbolCounts() const
 {
+    const QMutexLocker locker(&m_symbolCountsMutex);
+    if (!m_hasSymbolCounts) {
+        m_hasSymbolCounts = true;
+        countSymbols();
+    }
+
     return m_symbolCounts;
 }
 
 int Docset::symbolCount(const QString &symbolType) const
 {
-    return m_symbolCounts.value(symbolType);
+    return symbolCounts().value(symbolType);
 }
 
 const QList<std::pair<QString, QUrl>> &Docset::symbols(const QString &symbolType) const
 {
     if (!m_symbols.contains(symbolType)) {
+        // Maps the symbol type to the strings used in the database.
+        symbolCounts();
+
         loadSymbols(symbolType);
     }
     return m_symbols[symbolType];
 }
 
-QList<SearchResult> Docset::search(const QString &query, const std::atomic_bool &canceled) const
+QList<SearchResult> Docset::search(const QString &query,
+                                   const std::atomic_bool &canceled,
+                                   const SearchOptions &options) const
 {
+    if (const auto index = symbolIndex()) {
+        return searchSymbolIndex(*index, query, canceled, options);
+    }
+
+    const QMutexLocker locker(&m_searchConnection.mutex);
+    Util::Database *db = database(m_searchConnection);
+    if (db == nullptr) {
+        return {};
+    }
+
+    // Sorting by score has to visit every row before the first step() returns,
+    // so checking canceled between rows alone would let stale queries run on.
+    db->setInterruptFlag(&canceled);
+    const auto interruptFlagGuard = qScopeGuard([db]() {
+        db->setInterruptFlag(nullptr);
+    });
+
+    const int limit = resultLimit(query, options.limit);
+    const bool isFuzzy = m_isFuzzySearchEnabled.load(std::memory_order_relaxed);
+
     if (query.isEmpty()) {
         // Keyword prefix only (e.g. "html:") — list all symbols alphabetically.
+        // Ordered like SearchResult, so that the limit keeps the rows that
+        // sort first. The name index makes this a short index scan.
         const QString sql = m_type == Docset::Type::Dash
-                              ? QStringLiteral("SELECT name, type, path, '' FROM searchIndex ORDER BY name LIMIT 1000")
-                              : QStringLiteral(
-                                    "SELECT name, type, path, fragment FROM searchIndex ORDER BY name LIMIT 1000");
-        Util::Statement stmt(*m_db, sql);
+                              ? QStringLiteral("SELECT name, type, path, '' FROM searchIndex"
+                                               "  ORDER BY name COLLATE NOCASE LIMIT ?")
+                              : QStringLiteral("SELECT name, type, path, fragment FROM searchIndex"
+                                               "  ORDER BY name COLLATE NOCASE LIMIT ?");
+        Util::Statement stmt(*db, sql);
+        stmt.bindInt(1, limit);
 
         QList<SearchResult> results;
         while (stmt.step() && !canceled.load(std::memory_order_relaxed)) {
             results.append({.name = stmt.value(0).toString(),
-                            .type = parseSymbolType(stmt.value(1).toString()),
-                            .url = createPageUrl(stmt.value(2).toString(), stmt.value(3).toString()),
-                            .docsetName = m_name,
-                            .docsetIcon = m_icon,
+                            .path = stmt.value(2).toString(),
+                            .fragment = stmt.value(3).toString(),
                             .score = 0,
-                            .matchPositions = {}});
+                            .typeId = symbolTypeId(stmt.value(1).toString()),
+                            .docsetId = m_docsetId});
         }
 
         return results;
     }
 
+    if (!isFuzzy) {
+        if (const auto index = trigramIndex()) {
+            QList<SearchResult> results;
+            const bool ok = index->search(query, limit, canceled, [this, &results](const Util::Statement &stmt) {
+                results.append({.name = stmt.value(0).toString(),
+                                .path = stmt.value(2).toString(),
+                                .fragment = stmt.value(3).toString(),
+                                .score = stmt.value(4).toDouble(),
+                                .typeId = symbolTypeId(stmt.value(1).toString()),
+                                .docsetId = m_docsetId});
+            });
+
+            if (ok) {
+                return results;
+            }
+        }
+    }
+
     QString sql;
     if (m_type == Docset::Type::Dash) {
-        if (m_isFuzzySearchEnabled) {
+        if (isFuzzy) {
             sql = QStringLiteral("SELECT name, type, path, '', zealScore(?, name) as score"
                                  "  FROM searchIndex"
                                  "  WHERE score > 0"
-                                 "  ORDER BY score DESC");
+                                 "  ORDER BY score DESC, name COLLATE NOCASE");
         } else {
             sql = QStringLiteral("SELECT name, type, path, '', -length(name) as score"
                                  "  FROM searchIndex"
                                  "  WHERE (name LIKE ? ESCAPE '\\')"
-                                 "  ORDER BY score DESC");
+                                 "  ORDER BY score DESC, name COLLATE NOCASE");
         }
     } else {
-        if (m_isFuzzySearchEnabled) {
+        if (isFuzzy) {
             sql = QStringLiteral("SELECT name, type, path, fragment, zealScore(?, name) as score"
                                  "  FROM searchIndex"
                                  "  WHERE score > 0"
-                                 "  ORDER BY score DESC");
+                                 "  ORDER BY score DESC, name COLLATE NOCASE");
         } else {
             sql = QStringLiteral("SELECT name, type, path, fragment, -length(name) as score"
                                  "  FROM searchIndex"
                                  "  WHERE (name LIKE ? ESCAPE '\\')"
-                                 "  ORDER BY score DESC");
+                                 "  ORDER BY score DESC, name COLLATE NOCASE");
         }
     }
 
-    // Limit for very short queries.
-    // TODO: Show a notification about the reduced result set.
-    if (query.size() < 3) {
-        sql += QLatin1String("  LIMIT 1000");
+    // With ORDER BY ... LIMIT, SQLite keeps only the best rows in a bounded
+    // sorter. Ties on score are broken by name as in SearchResult, so that
+    // the rows kept are the ones that would sort first without the limit.
+    if (limit > 0) {
+        sql += QLatin1String("  LIMIT ?");
     }
 
-    Util::Statement stmt(*m_db, sql);
+    Util::Statement stmt(*db, sql);
     QString likePattern;
-    if (m_isFuzzySearchEnabled) {
+    if (isFuzzy) {
         stmt.bindText(1, query);
     } else {
         likePattern = QLatin1Char('%') + Util::escapeLikePattern(query) + QLatin1Char('%');
         stmt.bindText(1, likePattern);
     }
 
+    if (limit > 0) {
+        stmt.bindInt(2, limit);
+    }
+
     QList<SearchResult> results;
     while (stmt.step() && !canceled.load(std::memory_order_relaxed)) {
         SearchResult result;
         result.name = stmt.value(0).toString();
-        result.type = parseSymbolType(stmt.value(1).toString());
-        result.url = createPageUrl(stmt.value(2).toString(), stmt.value(3).toString());
-        result.docsetName = m_name;
-        result.docsetIcon = m_icon;
+        result.path = stmt.value(2).toString();
+        result.fragment = stmt.value(3).toString();
         result.score = stmt.value(4).toDouble();
-
-        // Compute match positions for highlighting.
-        if (m_isFuzzySearchEnabled) {
-            // Fuzzy search: use fuzzy matching algorithm.
-            Util::Fuzzy::score(query, result.name, &result.matchPositions);
-        } else {
-            // Non-fuzzy search: highlight only first occurrence.
-            const qsizetype pos = result.name.indexOf(query, 0, Qt::CaseInsensitive);
-            if (pos != -1) {
-                for (int i = 0; i < query.length(); ++i) {
-                    result.matchPositions.append(static_cast<int>(pos + i));
-                }
-            }
-        }
+        result.typeId = symbolTypeId(stmt.value(1).toString());
+        result.docsetId = m_docsetId;
 
         results.append(std::move(result));
     }
@@ -467,6 +613,12 @@ QList<SearchResult> Docset::relatedLinks(const QUrl &url) const
         return {};
     }
 
+    const QMutexLocker locker(&m_connection.mutex);
+    Util::Database *db = database(m_connection);
+    if (db == nullptr) {
+        return {};
+    }
+
     // Get page path within the docset.
     const QString path = url.path().mid(m_baseUrl.path().length() + 1);
 
@@ -484,7 +636,7 @@ QList<SearchResult> Docset::relatedLinks(const QUrl &url) const
 
     QList<SearchResult> results;
 
-    Util::Statement stmt(*m_db, sql);
+    Util::Statement stmt(*db, sql);
     if (m_type == Docset::Type::Dash) {
         const QString likePattern = Util::escapeLikePattern(path) + QLatin1Char('%');
         stmt.bindText(1, likePattern);
@@ -495,12 +647,11 @@ QList<SearchResult> Docset::relatedLinks(const QUrl &url) const
 
     while (stmt.step()) {
         results.append({.name = stmt.value(0).toString(),
-                        .type = parseSymbolType(stmt.value(1).toString()),
-                        .url = createPageUrl(stmt.value(2).toString(), stmt.value(3).toString()),
-                        .docsetName = m_name,
-                        .docsetIcon = m_icon,
+                        .path = stmt.value(2).toString(),
+                        .fragment = stmt.value(3).toString(),
                         .score = 0,
-                        .matchPositions = {}});
+                        .typeId = symbolTypeId(stmt.value(1).toString()),
+                        .docsetId = m_docsetId});
     }
 
     if (results.size() == 1) {
@@ -560,12 +711,73 @@ void Docset::loadMetadata()
     }
 }
 
-void Docset::countSymbols()
+bool Docset::openStorage()
 {
+    QDir dir(m_path);
+    if (!dir.cd(QStringLiteral("Contents/Resources"))) {
+        qCWarning(log,
+                  "[%s] Cannot change directory into 'Contents/Resources' at '%s'.",
+                  qPrintable(m_name),
+                  qPrintable(m_path));
+        return false;
+    }
+
+    if (!dir.exists(QStringLiteral("docSet.dsidx"))) {
+        qCWarning(log, "[%s] Cannot access 'docSet.dsidx' at '%s'.", qPrintable(m_name), qPrintable(m_path));
+        return false;
+    }
+
+    // The database is only opened on first use, see database().
+    const QFileInfo databaseInfo(dir.absoluteFilePath(QStringLiteral("docSet.dsidx")));
+    m_databasePath = databaseInfo.filePath();
+    m_databaseSize = databaseInfo.size();
+
+    // Archived docsets keep documents in a tarix archive instead of a Documents directory.
+    if (dir.exists(QStringLiteral("tarix.tgz")) && dir.exists(QStringLiteral("tarixIndex.db"))) {
+        auto archive = std::make_unique<Util::TarixArchive>(dir.filePath(QStringLiteral("tarix.tgz")),
+                                                            dir.filePath(QStringLiteral("tarixIndex.db")));
+        if (!archive->isOpen()) {
+            qCWarning(log, "[%s] Cannot open tarix archive: %s.", qPrintable(m_name), qPrintable(archive->lastError()));
+            return false;
+        }
+
+        m_tarixArchive = std::move(archive);
+    } else if (!dir.exists(QStringLiteral("Documents"))) {
+        qCWarning(log,
+                  "[%s] Cannot change directory into 'Documents' at '%s'.",
+                  qPrintable(m_name),
+                  qPrintable(m_path));
+        return false;
+    }
+
+    return true;
+}
+
+void Docset::setIndexFilePath(const QString &path)
+{
+    m_indexFilePath = path;
+
+    // Log if unable to determine the index page. Otherwise the path will be set in setBaseUrl().
+    if (m_indexFilePath.isEmpty()) {
+        qCInfo(log, "[%s] Cannot determine index file.", qPrintable(m_name));
+        m_indexFileUrl.setUrl(NotFoundPageUrl);
+    } else {
+        m_indexFileUrl = createPageUrl(m_baseUrl, m_indexFilePath);
+    }
+}
+
+void Docset::countSymbols() const
+{
+    const QMutexLocker locker(&m_connection.mutex);
+    Util::Database *db = database(m_connection);
+    if (db == nullptr) {
+        return;
+    }
+
     static const QString sql = QStringLiteral("SELECT type, COUNT(*)"
                                               "  FROM searchIndex"
                                               "  GROUP BY type");
-    Util::Statement stmt(*m_db, sql);
+    Util::Statement stmt(*db, sql);
     if (!stmt.isValid()) {
         qCWarning(log,
                   "[%s] Cannot prepare statement to count symbols: %s.",
@@ -603,6 +815,12 @@ void Docset::loadSymbols(const QString &symbolType) const
 
 void Docset::loadSymbols(const QString &symbolType, const QString &symbolString) const
 {
+    const QMutexLocker locker(&m_connection.mutex);
+    Util::Database *db = database(m_connection);
+    if (db == nullptr) {
+        return;
+    }
+
     QString sql;
     if (m_type == Docset::Type::Dash) {
         sql = QStringLiteral("SELECT name, path"
@@ -616,7 +834,7 @@ void Docset::loadSymbols(const QString &symbolType, const QString &symbolString)
                              "  ORDER BY name");
     }
 
-    Util::Statement stmt(*m_db, sql);
+    Util::Statement stmt(*db, sql);
     if (!stmt.isValid()) {
         qCWarning(log,
                   "[%s] Cannot prepare statement to load symbols for type '%s': %s.",
@@ -630,65 +848,311 @@ void Docset::loadSymbols(const QString &symbolType, const QString &symbolString)
     QList<std::pair<QString, QUrl>> &symbols = m_symbols[symbolType];
     while (stmt.step()) {
         symbols.emplace_back(stmt.value(0).toString(),
-                             createPageUrl(stmt.value(1).toString(), stmt.value(2).toString()));
+                             createPageUrl(m_baseUrl, stmt.value(1).toString(), stmt.value(2).toString()));
     }
 }
 
-void Docset::createIndex()
+Util::Database *Docset::database(Connection &connection) const
 {
-    static const QString indexListQuery = QStringLiteral("PRAGMA INDEX_LIST('%1')");
-    static const QString indexDropQuery = QStringLiteral("DROP INDEX '%1'");
-    static const QString indexCreateQuery = QStringLiteral("CREATE INDEX IF NOT EXISTS %1%2"
-                                                           " ON %3 (%4 COLLATE NOCASE)");
+    if (!connection.isOpenAttempted) {
+        connection.isOpenAttempted = true;
+        connection.db = openDatabase();
+    }
 
-    const QString tableName = m_type == Type::Dash ? QStringLiteral("searchIndex") : QStringLiteral("ztoken");
-    const QString columnName = m_type == Type::Dash ? QStringLiteral("name") : QStringLiteral("ztokenname");
+    if (connection.db == nullptr) {
+        return nullptr;
+    }
 
-    Util::Statement stmt(*m_db, indexListQuery.arg(tableName));
+    useNameIndex(connection);
+    return connection.db.get();
+}
 
-    QStringList oldIndexes;
+std::unique_ptr<Util::Database> Docset::openDatabase() const
+{
+    const QMutexLocker locker(&m_databaseMutex);
+    if ((m_isDatabaseOpenAttempted && m_type == Type::Invalid) || m_hasDatabaseError.load(std::memory_order_relaxed)) {
+        return nullptr;
+    }
 
-    while (stmt.step()) {
-        const QString indexName = stmt.value(1).toString();
-        if (!indexName.startsWith(IndexNamePrefix)) {
-            continue;
+    const bool isFirstOpen = !m_isDatabaseOpenAttempted;
+    m_isDatabaseOpenAttempted = true;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // Searches use a read-only connection, schema changes are left to the
+    // name index build. Nothing writes to docsets on read-only storage, so
+    // they are opened as immutable, which also skips file locking.
+    const bool isWritable = isWritableDatabase(m_databasePath);
+
+    using OpenMode = Util::Database::OpenMode;
+    auto db = std::make_unique<Util::Database>(
+        m_databasePath,
+        Util::Database::OpenOptions{.mode = isWritable ? OpenMode::ReadOnly : OpenMode::Immutable,
+                                    .mmapSize = DatabaseMmapSize,
+                                    .cacheSize = DatabaseCacheSize,
+                                    .busyTimeout = DatabaseBusyTimeout});
+    if (!db->isOpen()) {
+        qCWarning(log, "[%s] Cannot open database: %s.", qPrintable(m_name), qPrintable(db->lastError()));
+        reportDatabaseError();
+        return nullptr;
+    }
+
+    sqlite3_create_function(db->handle(),
+                            "zealScore",
+                            2,
+                            SQLITE_UTF8,
+                            nullptr,
+                            sqliteScoreFunction,
+                            nullptr,
+                            nullptr);
+
+    // Opening is lazy, a corrupt file only shows when it is read.
+    const Type type = databaseType(*db);
+    if (type == Type::Invalid) {
+        qCWarning(log,
+                  "[%s] Cannot find symbols in database '%s': %s.",
+                  qPrintable(m_name),
+                  qPrintable(m_databasePath),
+                  qPrintable(db->lastError()));
+        reportDatabaseError();
+        return nullptr;
+    }
+
+    // Searched through the join until the name index build has materialized
+    // it, or for good on read-only storage.
+    if (type == Type::ZDash && !db->views().contains(QStringLiteral("searchIndex"), Qt::CaseInsensitive)) {
+        db->execute(QStringLiteral("CREATE TEMP VIEW searchIndex AS") + symbolJoinQuery());
+    }
+
+    if (isFirstOpen) {
+        m_type = type;
+        startNameIndex(isWritable);
+    }
+
+    qCDebug(log, "[%s] Opened database in %lld ms.", qPrintable(m_name), timer.elapsed());
+    return db;
+}
+
+void Docset::reportDatabaseError() const
+{
+    if (m_hasDatabaseError.exchange(true) || !m_databaseErrorHandler) {
+        return;
+    }
+
+    m_databaseErrorHandler();
+}
+
+Docset::Type Docset::databaseType(Util::Database &db)
+{
+    const QStringList tables = db.tables();
+    if (tables.contains(QStringLiteral("searchIndex"), Qt::CaseInsensitive)) {
+        return Type::Dash;
+    }
+
+    if (tables.contains(QStringLiteral("ztoken"), Qt::CaseInsensitive)) {
+        return Type::ZDash;
+    }
+
+    return Type::Invalid;
+}
+
+void Docset::startNameIndex(bool isWritable) const
+{
+    if (!isWritable && m_nameIndexPath.isEmpty()) {
+        qCDebug(log, "[%s] Docset storage is read-only, searching without a name index.", qPrintable(m_name));
+        return;
+    }
+
+    // Searches go without the index until it is ready, see useNameIndex().
+    const QMutexLocker locker(&m_nameIndexMutex);
+    m_nameIndex = std::make_unique<NameIndex>(m_name,
+                                              m_databasePath,
+                                              m_type == Type::ZDash,
+                                              isWritable ? QString() : m_nameIndexPath,
+                                              [this](const QList<qint64> &previousStamp) {
+                                                  restampDatabase(previousStamp);
+                                              });
+}
+
+void Docset::restampDatabase(const QList<qint64> &previousStamp) const
+{
+    const QMutexLocker locker(&m_fileStampMutex);
+    if (!ManifestCache::restampDatabase(&m_fileStamp, m_path, previousStamp)) {
+        qCDebug(log, "[%s] Database was changed before the name index build.", qPrintable(m_name));
+    }
+}
+
+void Docset::useNameIndex(Connection &connection) const
+{
+    // Failed attaches are retried once in a while, e.g. after a sidecar on
+    // removable storage comes back.
+    if (connection.hasNameIndex
+        || (connection.lastNameIndexAttempt.isValid()
+            && !connection.lastNameIndexAttempt.hasExpired(NameIndexRetryInterval))) {
+        return;
+    }
+
+    const QMutexLocker locker(&m_nameIndexMutex);
+    if (m_nameIndex == nullptr || !m_nameIndex->isReady()) {
+        return;
+    }
+
+    // No statements are running on the connection, its mutex is held.
+    if (!m_nameIndex->attach(connection.db.get())) {
+        connection.lastNameIndexAttempt.start();
+        return;
+    }
+
+    connection.hasNameIndex = true;
+    qCDebug(log, "[%s] Using name index.", qPrintable(m_name));
+}
+
+std::shared_ptr<const SymbolIndex> Docset::symbolIndex() const
+{
+    const QMutexLocker locker(&m_symbolIndexMutex);
+    if (!m_isSymbolIndexEnabled || m_symbolIndex != nullptr || m_hasSymbolIndexFailed) {
+        return m_symbolIndex;
+    }
+
+    // Searches go through the database until the index is ready. A build
+    // canceled by disabling the index is waited out before starting anew.
+    if (m_symbolIndexBuildFuture.isFinished()) {
+        m_isSymbolIndexBuildCanceled.store(false, std::memory_order_relaxed);
+        m_symbolIndexBuildFuture = QtConcurrent::run(IndexBuild::threadPool(), [this]() {
+            buildSymbolIndex();
+        });
+    }
+
+    return {};
+}
+
+void Docset::buildSymbolIndex() const
+{
+    if (m_isSymbolIndexBuildCanceled.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // Read on a connection of its own, so that searches are not held up. The
+    // symbol join of a ZDash docset is read directly, since the searchIndex
+    // view may only exist on the docset connections.
+    using OpenMode = Util::Database::OpenMode;
+    Util::Database db(m_databasePath,
+                      {.mode = isWritableDatabase(m_databasePath) ? OpenMode::ReadOnly : OpenMode::Immutable,
+                       .busyTimeout = DatabaseBusyTimeout});
+    db.setInterruptFlag(&m_isSymbolIndexBuildCanceled);
+
+    const Type type = db.isOpen() ? databaseType(db) : Type::Invalid;
+    const QString sql = type == Type::Dash ? QStringLiteral("SELECT name, type, path, '' FROM searchIndex")
+                                           : symbolJoinQuery();
+
+    auto index = std::make_shared<SymbolIndex>();
+    QString error = db.isOpen() ? QStringLiteral("no symbol tables found") : db.lastError();
+    if (type != Type::Invalid) {
+        Util::Statement stmt(db, sql);
+        while (stmt.step()) {
+            index->append(stmt.value(0).toString(),
+                          parseSymbolType(stmt.value(1).toString()),
+                          stmt.value(2).toString(),
+                          stmt.value(3).toString());
         }
 
-        if (indexName.endsWith(IndexNameVersion)) {
-            return;
+        error = stmt.lastError();
+    }
+
+    const QMutexLocker locker(&m_symbolIndexMutex);
+    if (m_isSymbolIndexBuildCanceled.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    // Not retried, searches keep going through the database.
+    if (!error.isEmpty()) {
+        qCWarning(log, "[%s] Cannot build symbol index: %s.", qPrintable(m_name), qPrintable(error));
+        m_hasSymbolIndexFailed = true;
+        return;
+    }
+
+    index->squeeze();
+    qCDebug(log,
+            "[%s] Built symbol index with %d symbols in %lld ms.",
+            qPrintable(m_name),
+            index->size(),
+            timer.elapsed());
+
+    m_symbolIndex = std::move(index);
+}
+
+std::shared_ptr<const TrigramIndex> Docset::trigramIndex() const
+{
+    const QMutexLocker locker(&m_trigramIndexMutex);
+
+    // A failed build is tried again after a while, e.g. once a locked docset
+    // database has been released.
+    if (m_trigramIndex != nullptr && m_trigramIndex->hasFailed()) {
+        if (!m_trigramIndexFailureTimer.isValid()) {
+            m_trigramIndexFailureTimer.start();
+        } else if (m_trigramIndexFailureTimer.hasExpired(TrigramIndexRetryInterval)) {
+            m_trigramIndexFailureTimer.invalidate();
+            m_trigramIndex.reset();
         }
+    }
 
-        oldIndexes << indexName;
+    // The docset type is only known once the database has been opened, so
+    // not before the first search, which opens it.
+    if (m_trigramIndex == nullptr && !m_trigramIndexPath.isEmpty() && m_type != Type::Invalid) {
+        m_trigramIndex
+            = std::make_shared<TrigramIndex>(m_name, m_databasePath, m_type == Type::ZDash, m_trigramIndexPath);
     }
 
-    // Drop old indexes
-    for (const QString &oldIndexName : std::as_const(oldIndexes)) {
-        m_db->execute(indexDropQuery.arg(oldIndexName));
+    if (m_trigramIndex == nullptr || !m_trigramIndex->isReady()) {
+        return nullptr;
     }
 
-    m_db->execute(indexCreateQuery.arg(IndexNamePrefix, IndexNameVersion, tableName, columnName));
+    return m_trigramIndex;
 }
 
-void Docset::createView()
+QList<SearchResult> Docset::searchSymbolIndex(const SymbolIndex &index,
+                                              const QString &query,
+                                              const std::atomic_bool &canceled,
+                                              const SearchOptions &options) const
 {
-    static const QString viewCreateQuery = QStringLiteral("CREATE VIEW IF NOT EXISTS searchIndex AS"
-                                                          "  SELECT"
-                                                          "    ztokenname AS name,"
-                                                          "    ztypename AS type,"
-                                                          "    zpath AS path,"
-                                                          "    zanchor AS fragment"
-                                                          "  FROM ztoken"
-                                                          "  INNER JOIN ztokenmetainformation"
-                                                          "    ON ztoken.zmetainformation = ztokenmetainformation.z_pk"
-                                                          "  INNER JOIN zfilepath"
-                                                          "    ON ztokenmetainformation.zfile = zfilepath.z_pk"
-                                                          "  INNER JOIN ztokentype"
-                                                          "    ON ztoken.ztokentype = ztokentype.z_pk");
+    QList<int> matchedRows;
+    const QList<SymbolIndex::Match> matches = index.search(query,
+                                                           m_isFuzzySearchEnabled.load(std::memory_order_relaxed),
+                                                           resultLimit(query, options.limit),
+                                                           canceled,
+                                                           options.candidates,
+                                                           options.matchedRows != nullptr ? &matchedRows : nullptr);
+
+    if (options.matchedRows != nullptr && !query.isEmpty()) {
+        *options.matchedRows = std::move(matchedRows);
+    }
+
+    QList<SearchResult> results;
+    results.reserve(matches.size());
+    for (const SymbolIndex::Match &match : matches) {
+        if (canceled.load(std::memory_order_relaxed)) {
+            return {};
+        }
 
-    m_db->execute(viewCreateQuery);
+        SearchResult result;
+        result.name = index.name(match.row).toString();
+        result.path = index.path(match.row).toString();
+        result.fragment = index.fragment(match.row).toString();
+        result.score = match.score;
+        result.typeId = index.typeId(match.row);
+        result.docsetId = m_docsetId;
+
+        results.append(std::move(result));
+    }
+
+    return results;
 }
 
-QUrl Docset::createPageUrl(const QString &path, const QString &fragment) const
+QUrl Docset::createPageUrl(const QUrl &baseUrl, const QString &path, const QString &fragment)
 {
     QString realPath;
     QString realFragment;
@@ -706,8 +1170,8 @@ QUrl Docset::createPageUrl(const QString &path, const QString &fragment) const
     realPath.remove(dashEntryRegExp);
     realFragment.remove(dashEntryRegExp);
 
-    QUrl url = m_baseUrl;
-    url.setPath(m_baseUrl.path() + "/" + realPath, QUrl::TolerantMode);
+    QUrl url = baseUrl;
+    url.setPath(baseUrl.path() + "/" + realPath, QUrl::TolerantMode);
 
     if (!realFragment.isEmpty()) {
         if (realFragment.startsWith(QLatin1String("//apple_ref"))
@@ -721,6 +1185,11 @@ QUrl Docset::createPageUrl(const QString &path, const QString &fragment) const
     return url;
 }
 
+quint16 Docset::symbolTypeId(const QString &str)
+{
+    return SearchResult::internSymbolType(parseSymbolType(str));
+}
+
 QString Docset::parseSymbolType(const QString &str)
 {
     // Dash symbol aliases
@@ -865,20 +1334,70 @@ QUrl Docset::baseUrl() const
 void Docset::setBaseUrl(const QUrl &baseUrl)
 {
     m_baseUrl = baseUrl;
+    m_docsetId = SearchResult::internDocset(m_name, m_icon, m_baseUrl);
 
     if (!m_indexFilePath.isEmpty()) {
-        m_indexFileUrl = createPageUrl(m_indexFilePath);
+        m_indexFileUrl = createPageUrl(m_baseUrl, m_indexFilePath);
     }
 }
 
 bool Docset::isFuzzySearchEnabled() const
 {
-    return m_isFuzzySearchEnabled;
+    return m_isFuzzySearchEnabled.load(std::memory_order_relaxed);
 }
 
 void Docset::setFuzzySearchEnabled(bool enabled)
 {
-    m_isFuzzySearchEnabled = enabled;
+    m_isFuzzySearchEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool Docset::isSymbolIndexEnabled() const
+{
+    const QMutexLocker locker(&m_symbolIndexMutex);
+    return m_isSymbolIndexEnabled;
+}
+
+void Docset::setSymbolIndexEnabled(bool enabled)
+{
+    const QMutexLocker locker(&m_symbolIndexMutex);
+    m_isSymbolIndexEnabled = enabled;
+
+    // Searches still holding the previous index keep it alive until they finish.
+    if (!enabled) {
+        m_isSymbolIndexBuildCanceled.store(true, std::memory_order_relaxed);
+        m_symbolIndex.reset();
+        m_hasSymbolIndexFailed = false;
+    }
+}
+
+bool Docset::isSymbolIndexReady() const
+{
+    const QMutexLocker locker(&m_symbolIndexMutex);
+    return m_symbolIndex != nullptr;
+}
+
+void Docset::setTrigramIndexPath(const QString &path)
+{
+    const QMutexLocker locker(&m_trigramIndexMutex);
+    if (m_trigramIndexPath == path) {
+        return;
+    }
+
+    m_trigramIndexPath = path;
+    m_trigramIndex.reset();
+    m_trigramIndexFailureTimer.invalidate();
+}
+
+void Docset::setNameIndexPath(const QString &path)
+{
+    const QMutexLocker locker(&m_databaseMutex);
+    m_nameIndexPath = path;
+}
+
+int Docset::nameIndexProgress() const
+{
+    const QMutexLocker locker(&m_nameIndexMutex);
+    return m_nameIndex != nullptr ? m_nameIndex->progress() : -1;
 }
 
 bool Docset::isJavaScriptEnabled() const
@@ -886,4 +1405,9 @@ bool Docset::isJavaScriptEnabled() const
     return m_isJavaScriptEnabled;
 }
 
+void Docset::setDatabaseErrorHandler(std::function<void()> handler)
+{
+    m_databaseErrorHandler = std::move(handler);
+}
+
 } // namespace Zeal::Registry
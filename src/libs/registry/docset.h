@@ -5,14 +5,18 @@
 #ifndef ZEAL_REGISTRY_DOCSET_H
 #define ZEAL_REGISTRY_DOCSET_H
 
+#include <QElapsedTimer>
+#include <QFuture>
 #include <QIcon>
 #include <QList>
 #include <QMap>
 #include <QMetaObject>
 #include <QMultiMap>
+#include <QMutex>
 #include <QUrl>
 
 #include <atomic>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <utility>
@@ -26,15 +30,47 @@ class TarixArchive;
 
 namespace Registry {
 
+class NameIndex;
 struct SearchResult;
+class SymbolIndex;
+class TrigramIndex;
 
 class Docset final
 {
     Q_DISABLE_COPY_MOVE(Docset)
 public:
+    // What loading reads from meta.json, Info.plist and the symbol database,
+    // so that unchanged docsets can be loaded without reading them, see ManifestCache.
+    struct ManifestEntry
+    {
+        QString name;
+        QString title;
+        QStringList keywords;
+        QString version;
+        int revision = 0;
+        QString feedUrl;
+        QString iconPath;
+        QString indexFilePath;
+        bool isJavaScriptEnabled = false;
+
+        bool hasSymbolCounts = false; // Whether symbols have been counted.
+        QMultiMap<QString, QString> symbolStrings;
+        QMap<QString, int> symbolCounts;
+
+        // Sizes and modification times of the files above, taken before they
+        // were read, see ManifestCache::fileStamp().
+        QList<qint64> fileStamp;
+    };
+
     explicit Docset(QString path);
+    Docset(QString path, const ManifestEntry &entry);
     ~Docset();
 
+    ManifestEntry manifestEntry() const;
+    // ManifestEntry::fileStamp, kept up to date with the name index build
+    // writing to the database, so that the docset does not look changed.
+    QList<qint64> fileStamp() const;
+
     bool isValid() const;
 
     QString name() const;
@@ -54,13 +90,33 @@ public:
     QIcon icon() const;
     static QIcon symbolTypeIcon(const QString &symbolType);
     QUrl indexFileUrl() const;
+    static QUrl createPageUrl(const QUrl &baseUrl, const QString &path, const QString &fragment = QString());
 
+    // Size of the symbol database in bytes, a rough search cost that does not
+    // require opening it.
+    qint64 databaseSize() const;
+
+    // Counting symbols opens the database, see database().
     QMap<QString, int> symbolCounts() const;
     int symbolCount(const QString &symbolType) const;
 
     const QList<std::pair<QString, QUrl>> &symbols(const QString &symbolType) const;
 
-    QList<SearchResult> search(const QString &query, const std::atomic_bool &canceled) const;
+    // Result limit and incremental refinement state for search(), owned by the caller.
+    struct SearchOptions
+    {
+        // Keep only the best results, 0 for all of them.
+        int limit = 0;
+        // Symbol index rows matched by a query that the current query extends.
+        const QList<int> *candidates = nullptr;
+        // Receives rows that may match an extension of the current query. Left
+        // empty when the symbol index is not in use, since SQL rows have no ids.
+        std::optional<QList<int>> *matchedRows = nullptr;
+    };
+
+    QList<SearchResult> search(const QString &query,
+                               const std::atomic_bool &canceled,
+                               const SearchOptions &options = {}) const;
     QList<SearchResult> relatedLinks(const QUrl &url) const;
 
     // Update availability lives here until a proper docset catalog implementation exists.
@@ -81,8 +137,30 @@ public:
     bool isFuzzySearchEnabled() const;
     void setFuzzySearchEnabled(bool enabled);
 
+    // When enabled, search() scans an in-memory copy of the symbol table. It is
+    // built in the background on first use, searches go through the database
+    // until it is ready.
+    bool isSymbolIndexEnabled() const;
+    void setSymbolIndexEnabled(bool enabled);
+    bool isSymbolIndexReady() const;
+
+    // Substring searches of three or more characters use a trigram index kept
+    // at path, built in the background after the first search. Empty path disables it.
+    void setTrigramIndexPath(const QString &path);
+
+    // The case-insensitive name index is built in the background once the
+    // database is opened, see NameIndex. On read-only storage it is built into
+    // a sidecar at path, empty path skips it there. Applies to the next open.
+    void setNameIndexPath(const QString &path);
+    // Name index build progress in percent, or -1 when not building.
+    int nameIndexProgress() const;
+
     bool isJavaScriptEnabled() const;
 
+    // Called once, on the thread that tried to open it, when the database turns
+    // out to be missing or unreadable. The docset is invalid from then on.
+    void setDatabaseErrorHandler(std::function<void()> handler);
+
 private:
     enum class Type {
         Invalid,
@@ -90,15 +168,43 @@ private:
         ZDash
     };
 
+    // A connection to the docset database. Statements only run on it with
+    // mutex held, so that it can be changed in between, see useNameIndex().
+    struct Connection
+    {
+        QMutex mutex;
+        std::unique_ptr<Util::Database> db;
+        bool isOpenAttempted = false;
+        bool hasNameIndex = false;
+        QElapsedTimer lastNameIndexAttempt; // Valid once attaching has failed.
+    };
+
     void loadMetadata();
-    void countSymbols();
+    bool openStorage();
+    void setIndexFilePath(const QString &path);
+    // Opens connection on first use, so that loading docsets only reads their
+    // metadata. The caller must hold connection.mutex for as long as it uses
+    // the result. Returns nullptr if the database cannot be opened.
+    Util::Database *database(Connection &connection) const;
+    std::unique_ptr<Util::Database> openDatabase() const;
+    void countSymbols() const;
     void loadSymbols(const QString &symbolType) const;
     void loadSymbols(const QString &symbolType, const QString &symbolString) const;
-    void createIndex();
-    void createView();
-    QUrl createPageUrl(const QString &path, const QString &fragment = QString()) const;
+    void reportDatabaseError() const;
+    static Type databaseType(Util::Database &db);
+    void startNameIndex(bool isWritable) const;
+    void restampDatabase(const QList<qint64> &previousStamp) const;
+    void useNameIndex(Connection &connection) const;
+    std::shared_ptr<const SymbolIndex> symbolIndex() const;
+    void buildSymbolIndex() const;
+    std::shared_ptr<const TrigramIndex> trigramIndex() const;
+    QList<SearchResult> searchSymbolIndex(const SymbolIndex &index,
+                                          const QString &query,
+                                          const std::atomic_bool &canceled,
+                                          const SearchOptions &options) const;
 
     static QString parseSymbolType(const QString &str);
+    static quint16 symbolTypeId(const QString &str);
 
     QString m_name;
     QString m_title;
@@ -106,23 +212,58 @@ private:
     QString m_version;
     int m_revision = 0;
     QString m_feedUrl;
-    Docset::Type m_type = Type::Invalid;
+    bool m_isValid = false;
     QString m_path;
+    mutable QMutex m_fileStampMutex;
+    mutable QList<qint64> m_fileStamp; // Guarded by m_fileStampMutex.
+    QString m_iconPath;
     QIcon m_icon;
 
     QUrl m_indexFileUrl;
     QString m_indexFilePath;
 
-    QMultiMap<QString, QString> m_symbolStrings;
-    QMap<QString, int> m_symbolCounts;
+    mutable QMutex m_symbolCountsMutex;
+    mutable bool m_hasSymbolCounts = false;
+    mutable QMultiMap<QString, QString> m_symbolStrings;
+    mutable QMap<QString, int> m_symbolCounts;
     mutable QMap<QString, QList<std::pair<QString, QUrl>>> m_symbols;
-    Util::Database *m_db = nullptr;
+
+    QString m_databasePath;
+    qint64 m_databaseSize = 0;
+    // Searches get a connection of their own, so that canceling one does not
+    // interrupt statements for related links or symbol lists, or wait for them.
+    mutable Connection m_connection;
+    mutable Connection m_searchConnection;
+    mutable QMutex m_databaseMutex; // Locked after a connection mutex.
+    mutable bool m_isDatabaseOpenAttempted = false;
+    mutable Docset::Type m_type = Type::Invalid; // Known once the database is open.
+    mutable std::atomic_bool m_hasDatabaseError{false};
+    std::function<void()> m_databaseErrorHandler;
+    QString m_nameIndexPath;                      // Guarded by m_databaseMutex.
     std::unique_ptr<Util::TarixArchive> m_tarixArchive;
 
-    bool m_isFuzzySearchEnabled = false;
+    std::atomic_bool m_isFuzzySearchEnabled{false}; // Set from the UI thread.
     bool m_isJavaScriptEnabled = false;
 
+    bool m_isSymbolIndexEnabled = false;
+    mutable QMutex m_symbolIndexMutex;
+    mutable std::shared_ptr<const SymbolIndex> m_symbolIndex;
+    mutable bool m_hasSymbolIndexFailed = false;
+    mutable QFuture<void> m_symbolIndexBuildFuture;
+    // Set when the index is disabled or the docset destroyed during a build.
+    mutable std::atomic_bool m_isSymbolIndexBuildCanceled{false};
+
+    mutable QMutex m_trigramIndexMutex;
+    QString m_trigramIndexPath;
+    mutable std::shared_ptr<const TrigramIndex> m_trigramIndex;
+    mutable QElapsedTimer m_trigramIndexFailureTimer; // Since the build of m_trigramIndex failed.
+
+    // Attached to each connection once built. Locked after m_databaseMutex.
+    mutable QMutex m_nameIndexMutex;
+    mutable std::unique_ptr<NameIndex> m_nameIndex;
+
     QUrl m_baseUrl;
+    quint16 m_docsetId = 0; // See SearchResult::internDocset().
 
     std::optional<UpdateInfo> m_update;
 };
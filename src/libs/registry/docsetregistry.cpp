@@ -6,35 +6,160 @@
 
 #include "docset.h"
 #include "listmodel.h"
+#include "manifestcache.h"
 #include "searchquery.h"
 #include "searchresult.h"
 
 #include <core/httpserver.h>
 
 #include <QDir>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
 #include <QLoggingCategory>
+#include <QMutex>
 #include <QScopeGuard>
 #include <QStack>
 #include <QThread>
+#include <QThreadPool>
+#include <QTimer>
+#include <QWaitCondition>
 #include <QtConcurrent>
 
 #include <algorithm>
+#include <optional>
+#include <utility>
+#include <vector>
 
 namespace Zeal::Registry {
 
 namespace {
 Q_LOGGING_CATEGORY(log, "zeal.registry.docsetregistry")
 
-void MergeQueryResults(QList<SearchResult> &finalResult, const QList<SearchResult> &partial)
+// Per-docset state of a single runQuery() pass.
+struct DocsetQuery
 {
-    finalResult << partial;
+    Docset *docset = nullptr;
+    const QList<int> *candidates = nullptr;
+    std::optional<QList<int>> matchedRows;
+    QList<SearchResult> results;
+};
+
+// Bounds the result cache by the memory of cached results rather than the
+// number of queries, since an unlimited search can return a whole docset.
+constexpr qsizetype ResultCacheMaxCost = 4 * 1024; // KiB
+
+// Extracting a docset changes its folder many times, wait for that to settle.
+constexpr int StorageWatchDelay = 1000; // ms
+
+// Settings that decide how a query is matched, and by which backend. Backends
+// agree on what matches, but not necessarily on ties at the result limit.
+struct SearchMode
+{
+    bool isFuzzy = false;
+    bool isSymbolIndexEnabled = false;
+    bool isTrigramIndexEnabled = false;
+};
+
+QString resultCacheKey(quint64 generation, QStringList keywords, const QString &query, SearchMode mode, int limit)
+{
+    keywords.sort();
+
+    return QStringLiteral("%1/%2%3%4/%5/%6:%7")
+        .arg(generation)
+        .arg(mode.isFuzzy ? 1 : 0)
+        .arg(mode.isSymbolIndexEnabled ? 1 : 0)
+        .arg(mode.isTrigramIndexEnabled ? 1 : 0)
+        .arg(limit)
+        .arg(keywords.join(QLatin1Char(',')), query);
+}
+
+// Approximate memory use of results in KiB, ignoring strings shared with copies.
+qsizetype resultCacheCost(const QList<SearchResult> &results)
+{
+    auto bytes = static_cast<qsizetype>(sizeof(SearchResult)) * results.size();
+    for (const SearchResult &result : results) {
+        bytes += static_cast<qsizetype>(sizeof(QChar))
+               * (result.name.size() + result.path.size() + result.fragment.size());
+    }
+
+    return bytes / 1024 + 1;
+}
+
+// K-way merge of result lists, each already sorted best first, keeping at most
+// limit results (0 for all of them). Results are moved out of the lists.
+QList<SearchResult> mergeResults(const QList<QList<SearchResult> *> &runs, int limit)
+{
+    struct Cursor
+    {
+        QList<SearchResult> *results = nullptr;
+        qsizetype pos = 0;
+    };
+
+    qsizetype total = 0;
+    std::vector<Cursor> heap;
+    heap.reserve(runs.size());
+    for (QList<SearchResult> *run : runs) {
+        if (!run->isEmpty()) {
+            total += run->size();
+            heap.push_back({.results = run, .pos = 0});
+        }
+    }
+
+    // Max-heap on rank: the cursor with the best pending result is on top.
+    const auto ranksLower = [](const Cursor &lhs, const Cursor &rhs) {
+        return rhs.results->at(rhs.pos) < lhs.results->at(lhs.pos);
+    };
+    std::ranges::make_heap(heap, ranksLower);
+
+    const qsizetype count = limit > 0 ? std::min<qsizetype>(limit, total) : total;
+
+    QList<SearchResult> results;
+    results.reserve(count);
+    while (results.size() < count) {
+        std::ranges::pop_heap(heap, ranksLower);
+        Cursor &cursor = heap.back();
+        results.append(std::move((*cursor.results)[cursor.pos]));
+
+        if (++cursor.pos < cursor.results->size()) {
+            std::ranges::push_heap(heap, ranksLower);
+        } else {
+            heap.pop_back();
+        }
+    }
+
+    return results;
+}
+
+QList<SearchResult> mergeResults(const QList<DocsetQuery *> &docsetQueries, int limit)
+{
+    QList<QList<SearchResult> *> runs;
+    runs.reserve(docsetQueries.size());
+    for (DocsetQuery *docsetQuery : docsetQueries) {
+        runs.append(&docsetQuery->results);
+    }
+
+    return mergeResults(runs, limit);
+}
+
+// Search cost estimate, so that the slowest docsets can be started first.
+// Symbol counts would be closer, but would open every database up front.
+qint64 searchCost(const Docset *docset)
+{
+    return docset->databaseSize();
 }
 
 // Construct a Docset, logging and returning nullptr on any exception so the
 // caller can skip rather than propagate out of QtConcurrent or signal slots.
-Docset *constructDocset(const QString &path)
+// Unchanged docsets found in manifestCache are loaded from their entries.
+Docset *constructDocset(const QString &path, const ManifestCache *manifestCache = nullptr)
 {
     try {
+        if (manifestCache != nullptr) {
+            if (const auto entry = manifestCache->entry(path)) {
+                return new Docset(path, *entry);
+            }
+        }
+
         return new Docset(path);
     } catch (const std::exception &e) {
         qCWarning(log, "Failed to construct docset from '%s': %s.", qPrintable(path), e.what());
@@ -50,27 +175,65 @@ DocsetRegistry::DocsetRegistry(Core::HttpServer *httpServer, QObject *parent)
     , m_model(new ListModel(this))
     , m_httpServer(httpServer)
     , m_thread(new QThread(this))
+    , m_searchThreadPool(new QThreadPool(this))
+    , m_loaderThread(new QThread(this))
+    , m_loader(new QObject())
+    , m_snapshot(std::make_shared<const Snapshot>())
+    , m_resultCache(ResultCacheMaxCost)
 {
     // Register for use in signal connections.
     qRegisterMetaType<QList<SearchResult>>("QList<SearchResult>");
 
-    // FIXME: Only search should be performed in a separate thread
     moveToThread(m_thread);
     m_thread->start();
+
+    // Created before moving the loader, so that they move along with it.
+    m_storageWatcher = new QFileSystemWatcher(m_loader);
+    m_storageWatchTimer = new QTimer(m_loader);
+    m_storageWatchTimer->setSingleShot(true);
+    m_storageWatchTimer->setInterval(StorageWatchDelay);
+
+    connect(m_storageWatcher,
+            &QFileSystemWatcher::directoryChanged,
+            m_storageWatchTimer,
+            qOverload<>(&QTimer::start));
+    connect(m_storageWatchTimer, &QTimer::timeout, m_loader, [this]() {
+        syncDocsetsFromFolder(storagePath());
+    });
+
+    m_loader->moveToThread(m_loaderThread);
+    m_loaderThread->start();
 }
 
 DocsetRegistry::~DocsetRegistry()
 {
+    // Searches stop first, since a docset whose database cannot be read posts
+    // its unloading to the loader, see registerDocset().
+    m_cancelSearch.store(true, std::memory_order_relaxed);
     m_thread->exit();
     m_thread->wait();
+    m_searchThreadPool->waitForDone();
+
+    m_loaderThread->exit();
+    m_loaderThread->wait();
+
+    // Docsets may outlive the registry while still referenced elsewhere.
+    const auto current = snapshot();
+    for (const auto &docset : current->docsets) {
+        docset->setDatabaseErrorHandler({});
+    }
 
-    // Unmount before deleting so the still-running HTTP server cannot invoke a
+    delete m_loader;
+
+    // Symbols counted during the session are only recorded now.
+    saveManifestCache();
+
+    // Unmount before releasing so the still-running HTTP server cannot invoke a
     // content provider that captured a docset being destroyed.
-    const auto names = m_docsets.keys();
+    const auto names = snapshot()->docsets.keys();
     for (const QString &name : names) {
         m_httpServer->unmount(name);
     }
-    qDeleteAll(m_docsets);
 }
 
 QAbstractItemModel *DocsetRegistry::model() const
@@ -80,16 +243,17 @@ QAbstractItemModel *DocsetRegistry::model() const
 
 QString DocsetRegistry::storagePath() const
 {
+    const QMutexLocker locker(&m_pathMutex);
     return m_storagePath;
 }
 
 void DocsetRegistry::setStoragePath(const QString &path)
 {
-    if (path == m_storagePath) {
+    if (path == storagePath()) {
         return;
     }
 
-    QMetaObject::invokeMethod(this, [this, path]() {
+    QMetaObject::invokeMethod(m_loader, [this, path]() {
         m_isLoadingDocsets.store(true, std::memory_order_relaxed);
         emit docsetLoadingStarted();
 
@@ -99,32 +263,147 @@ void DocsetRegistry::setStoragePath(const QString &path)
         });
 
         unloadAllDocsets();
+        m_docsetStamps.clear();
+        m_pendingDocsetStamps.clear();
         addDocsetsFromFolder(path);
-        m_storagePath = path;
+        {
+            const QMutexLocker locker(&m_pathMutex);
+            m_storagePath = path;
+        }
+        updateStorageWatch();
+    });
+}
+
+bool DocsetRegistry::isStorageWatchEnabled() const
+{
+    return m_isStorageWatchEnabled.load(std::memory_order_relaxed);
+}
+
+void DocsetRegistry::setStorageWatchEnabled(bool enabled)
+{
+    if (m_isStorageWatchEnabled.exchange(enabled, std::memory_order_relaxed) == enabled) {
+        return;
+    }
+
+    QMetaObject::invokeMethod(m_loader, [this]() {
+        updateStorageWatch();
     });
 }
 
 bool DocsetRegistry::isFuzzySearchEnabled() const
 {
-    return m_isFuzzySearchEnabled;
+    return m_isFuzzySearchEnabled.load(std::memory_order_relaxed);
 }
 
 void DocsetRegistry::setFuzzySearchEnabled(bool enabled)
 {
-    if (enabled == m_isFuzzySearchEnabled) {
+    if (m_isFuzzySearchEnabled.exchange(enabled, std::memory_order_relaxed) == enabled) {
         return;
     }
 
-    m_isFuzzySearchEnabled = enabled;
-
-    for (Docset *docset : std::as_const(m_docsets)) {
+    const auto current = snapshot();
+    for (const auto &docset : current->docsets) {
         docset->setFuzzySearchEnabled(enabled);
     }
 }
 
+bool DocsetRegistry::isSymbolIndexEnabled() const
+{
+    return m_isSymbolIndexEnabled.load(std::memory_order_relaxed);
+}
+
+void DocsetRegistry::setSymbolIndexEnabled(bool enabled)
+{
+    if (m_isSymbolIndexEnabled.exchange(enabled, std::memory_order_relaxed) == enabled) {
+        return;
+    }
+
+    const auto current = snapshot();
+    for (const auto &docset : current->docsets) {
+        docset->setSymbolIndexEnabled(enabled);
+    }
+}
+
+QString DocsetRegistry::cachePath() const
+{
+    const QMutexLocker locker(&m_pathMutex);
+    return m_cachePath;
+}
+
+void DocsetRegistry::setCachePath(const QString &path)
+{
+    {
+        const QMutexLocker locker(&m_pathMutex);
+        if (path == m_cachePath) {
+            return;
+        }
+
+        m_cachePath = path;
+    }
+
+    updateTrigramIndexes();
+}
+
+bool DocsetRegistry::isTrigramIndexEnabled() const
+{
+    return m_isTrigramIndexEnabled.load(std::memory_order_relaxed);
+}
+
+void DocsetRegistry::setTrigramIndexEnabled(bool enabled)
+{
+    if (m_isTrigramIndexEnabled.exchange(enabled, std::memory_order_relaxed) == enabled) {
+        return;
+    }
+
+    updateTrigramIndexes();
+}
+
+int DocsetRegistry::maxResults() const
+{
+    return m_maxResults.load(std::memory_order_relaxed);
+}
+
+void DocsetRegistry::setMaxResults(int count)
+{
+    m_maxResults.store(std::max(count, 0), std::memory_order_relaxed);
+}
+
+bool DocsetRegistry::isProgressiveSearchEnabled() const
+{
+    return m_isProgressiveSearchEnabled.load(std::memory_order_relaxed);
+}
+
+void DocsetRegistry::setProgressiveSearchEnabled(bool enabled)
+{
+    m_isProgressiveSearchEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+int DocsetRegistry::searchThreadCount() const
+{
+    return m_searchThreadCount;
+}
+
+void DocsetRegistry::setSearchThreadCount(int count)
+{
+    m_searchThreadCount = std::max(count, 0);
+    m_searchThreadPool->setMaxThreadCount(m_searchThreadCount > 0 ? m_searchThreadCount
+                                                                  : QThread::idealThreadCount());
+}
+
+QThread::Priority DocsetRegistry::searchThreadPriority() const
+{
+    return m_searchThreadPool->threadPriority();
+}
+
+void DocsetRegistry::setSearchThreadPriority(QThread::Priority priority)
+{
+    // Applies to threads started after the change.
+    m_searchThreadPool->setThreadPriority(priority);
+}
+
 int DocsetRegistry::count() const
 {
-    return static_cast<int>(m_docsets.count());
+    return static_cast<int>(snapshot()->docsets.count());
 }
 
 bool DocsetRegistry::isLoading() const
@@ -134,12 +413,12 @@ bool DocsetRegistry::isLoading() const
 
 bool DocsetRegistry::contains(const QString &name) const
 {
-    return m_docsets.contains(name);
+    return snapshot()->docsets.contains(name);
 }
 
 QStringList DocsetRegistry::names() const
 {
-    return m_docsets.keys();
+    return snapshot()->docsets.keys();
 }
 
 void DocsetRegistry::loadDocset(const QString &path)
@@ -161,11 +440,17 @@ void DocsetRegistry::registerDocset(Docset *docset)
         return;
     }
 
-    docset->setFuzzySearchEnabled(m_isFuzzySearchEnabled);
+    docset->setFuzzySearchEnabled(isFuzzySearchEnabled());
+    docset->setSymbolIndexEnabled(isSymbolIndexEnabled());
+    docset->setTrigramIndexPath(trigramIndexPath(docset->name()));
+    docset->setNameIndexPath(nameIndexPath(docset->name()));
+
+    // Docsets are registered and unloaded from the UI and the loader threads.
+    const QMutexLocker locker(&m_registrationMutex);
 
     const QString name = docset->name();
-    if (m_docsets.contains(name)) {
-        unloadDocset(name);
+    if (contains(name)) {
+        unloadDocsetLocked(name);
     }
 
     // Setup HTTP mount.
@@ -188,46 +473,109 @@ void DocsetRegistry::registerDocset(Docset *docset)
 
     docset->setBaseUrl(url);
 
-    m_docsets[name] = docset;
+    // Databases are opened on first use, so a missing or corrupt one is only
+    // noticed by a search. Such a docset is unloaded, unless replaced meanwhile.
+    docset->setDatabaseErrorHandler([this, name, docset]() {
+        QMetaObject::invokeMethod(m_loader, [this, name, docset]() {
+            const QMutexLocker locker(&m_registrationMutex);
+            const std::shared_ptr<Docset> current = this->docset(name);
+            if (current.get() != docset) {
+                return;
+            }
+
+            qCWarning(log,
+                      "Could not read database of docset '%s' from '%s'. Reinstall the docset.",
+                      qPrintable(name),
+                      qPrintable(current->path()));
+            unloadDocsetLocked(name);
+        });
+    });
+
+    updateSnapshot([name, docset](Snapshot &snapshot) {
+        snapshot.docsets.insert(name, std::shared_ptr<Docset>(docset));
+    });
 
     emit docsetLoaded(name);
 }
 
+QString DocsetRegistry::trigramIndexPath(const QString &name) const
+{
+    const QString path = cachePath();
+    if (!isTrigramIndexEnabled() || path.isEmpty()) {
+        return {};
+    }
+
+    return QDir(path).filePath(QStringLiteral("search-index/%1.sqlite").arg(name));
+}
+
+QString DocsetRegistry::nameIndexPath(const QString &name) const
+{
+    const QString path = cachePath();
+    if (path.isEmpty()) {
+        return {};
+    }
+
+    return QDir(path).filePath(QStringLiteral("name-index/%1.sqlite").arg(name));
+}
+
+void DocsetRegistry::updateTrigramIndexes()
+{
+    const auto current = snapshot();
+    for (const auto &docset : current->docsets) {
+        docset->setTrigramIndexPath(trigramIndexPath(docset->name()));
+    }
+}
+
 void DocsetRegistry::unloadDocset(const QString &name)
+{
+    const QMutexLocker locker(&m_registrationMutex);
+    unloadDocsetLocked(name);
+}
+
+void DocsetRegistry::unloadDocsetLocked(const QString &name)
 {
     emit docsetAboutToBeUnloaded(name);
     m_httpServer->unmount(name);
-    delete m_docsets.take(name);
+
+    // Searches still running on an older snapshot keep the docset alive.
+    updateSnapshot([name](Snapshot &snapshot) {
+        snapshot.docsets.remove(name);
+    });
+
     emit docsetUnloaded(name);
 }
 
 void DocsetRegistry::unloadAllDocsets()
 {
-    const auto keys = m_docsets.keys();
+    const QMutexLocker locker(&m_registrationMutex);
+
+    const auto keys = names();
     for (const QString &name : keys) {
-        unloadDocset(name);
+        unloadDocsetLocked(name);
     }
 }
 
-Docset *DocsetRegistry::docset(const QString &name) const
+std::shared_ptr<Docset> DocsetRegistry::docset(const QString &name) const
 {
-    return m_docsets[name];
+    return snapshot()->docsets.value(name);
 }
 
-Docset *DocsetRegistry::docset(int index) const
+std::shared_ptr<Docset> DocsetRegistry::docset(int index) const
 {
-    if (index < 0 || index >= m_docsets.size()) {
+    const auto current = snapshot();
+    if (index < 0 || index >= current->docsets.size()) {
         return nullptr;
     }
 
-    auto it = m_docsets.cbegin();
+    auto it = current->docsets.cbegin();
     std::advance(it, index);
     return *it;
 }
 
-Docset *DocsetRegistry::docsetForUrl(const QUrl &url)
+std::shared_ptr<Docset> DocsetRegistry::docsetForUrl(const QUrl &url)
 {
-    for (Docset *docset : std::as_const(m_docsets)) {
+    const auto current = snapshot();
+    for (const auto &docset : current->docsets) {
         if (docset->baseUrl().isParentOf(url)) {
             return docset;
         }
@@ -236,9 +584,51 @@ Docset *DocsetRegistry::docsetForUrl(const QUrl &url)
     return nullptr;
 }
 
-QList<Docset *> DocsetRegistry::docsets() const
+QList<std::shared_ptr<Docset>> DocsetRegistry::docsets() const
 {
-    return m_docsets.values();
+    return snapshot()->docsets.values();
+}
+
+QStringList DocsetRegistry::keywords() const
+{
+    QStringList list = snapshot()->docsetsByKeyword.keys();
+    list.sort();
+    return list;
+}
+
+std::shared_ptr<const DocsetRegistry::Snapshot> DocsetRegistry::snapshot() const
+{
+    const QMutexLocker locker(&m_snapshotMutex);
+    return m_snapshot;
+}
+
+void DocsetRegistry::updateSnapshot(const std::function<void(Snapshot &)> &update)
+{
+    const QMutexLocker writeLocker(&m_writeMutex);
+
+    auto next = std::make_shared<Snapshot>(*snapshot());
+    update(*next);
+    ++next->generation;
+
+    // Docset keywords are already lowercase.
+    next->docsetsByKeyword.clear();
+    for (const auto &docset : std::as_const(next->docsets)) {
+        const QStringList keywords = docset->keywords();
+        for (const QString &keyword : keywords) {
+            next->docsetsByKeyword[keyword].append(docset.get());
+        }
+    }
+
+    std::shared_ptr<const Snapshot> previous;
+    {
+        const QMutexLocker locker(&m_snapshotMutex);
+        previous = std::exchange(m_snapshot, std::move(next));
+    }
+
+    invalidateResultCache();
+
+    // The previous snapshot, and any docset removed from it, is released here
+    // outside of m_snapshotMutex, unless a search is still holding it.
 }
 
 void DocsetRegistry::search(const QString &query)
@@ -246,7 +636,7 @@ void DocsetRegistry::search(const QString &query)
     m_cancelSearch.store(true, std::memory_order_relaxed);
 
     if (query.isEmpty()) {
-        emit searchCompleted({});
+        emit searchCompleted({}, {});
         return;
     }
 
@@ -267,24 +657,213 @@ void DocsetRegistry::addDocsetsFromFolder(const QString &path)
         return;
     }
 
-    const QList<Docset *> docsets = QtConcurrent::blockingMapped(docsetPaths, &constructDocset);
+    // Taken before loading, so that changes made meanwhile are picked up.
+    for (const QString &docsetPath : docsetPaths) {
+        m_docsetStamps.insert(docsetPath, ManifestCache::fileStamp(docsetPath));
+    }
+
+    ManifestCache manifestCache(manifestCachePath());
+    if (!cachePath().isEmpty()) {
+        manifestCache.load();
+    }
+
+    const auto construct = [&manifestCache](const QString &docsetPath) {
+        return constructDocset(docsetPath, &manifestCache);
+    };
+    const QList<Docset *> docsets = QtConcurrent::blockingMapped(docsetPaths, construct);
 
     for (Docset *docset : docsets) {
         if (docset != nullptr) {
             registerDocset(docset);
         }
     }
+
+    saveManifestCache();
 }
 
-QStringList DocsetRegistry::collectDocsetPaths(const QString &path)
+void DocsetRegistry::syncDocsetsFromFolder(const QString &path)
+{
+    if (path.isEmpty() || !m_isStorageWatchEnabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    const QStringList docsetPaths = collectDocsetPaths(path);
+    const QHash<QString, QString> loaded = loadedDocsetPaths();
+
+    // Removed, including docsets whose folder was renamed.
+    for (auto it = loaded.cbegin(); it != loaded.cend(); ++it) {
+        if (!docsetPaths.contains(it.key())) {
+            qCDebug(log, "Docset '%s' was removed from '%s'.", qPrintable(it.value()), qPrintable(it.key()));
+            unloadDocset(it.value());
+        }
+    }
+
+    for (auto it = m_docsetStamps.begin(); it != m_docsetStamps.end();) {
+        it = docsetPaths.contains(it.key()) ? std::next(it) : m_docsetStamps.erase(it);
+    }
+
+    for (auto it = m_pendingDocsetStamps.begin(); it != m_pendingDocsetStamps.end();) {
+        it = docsetPaths.contains(it.key()) ? std::next(it) : m_pendingDocsetStamps.erase(it);
+    }
+
+    // Added or replaced. Docsets that failed to load are only retried once
+    // their files change, e.g. when extraction has progressed.
+    QStringList changedPaths;
+    for (const QString &docsetPath : docsetPaths) {
+        const QList<qint64> stamp = ManifestCache::fileStamp(docsetPath);
+        const auto it = m_docsetStamps.constFind(docsetPath);
+
+        if (it == m_docsetStamps.cend() && loaded.contains(docsetPath)) {
+            // Loaded outside of the folder scan, e.g. installed from the UI.
+            m_docsetStamps.insert(docsetPath, stamp);
+            m_pendingDocsetStamps.remove(docsetPath);
+            continue;
+        }
+
+        if (it != m_docsetStamps.cend() && *it == stamp) {
+            m_pendingDocsetStamps.remove(docsetPath);
+            continue;
+        }
+
+        // Written by the loaded docset itself, e.g. by its name index build.
+        if (it != m_docsetStamps.cend() && loaded.contains(docsetPath)) {
+            const std::shared_ptr<Docset> docset = this->docset(loaded.value(docsetPath));
+            if (docset != nullptr && docset->fileStamp() == stamp) {
+                m_docsetStamps.insert(docsetPath, stamp);
+                m_pendingDocsetStamps.remove(docsetPath);
+                continue;
+            }
+        }
+
+        // Files still being copied or extracted keep changing, so a change is
+        // only loaded once the next scan finds the same stamp.
+        const auto pending = m_pendingDocsetStamps.constFind(docsetPath);
+        if (pending == m_pendingDocsetStamps.cend() || *pending != stamp) {
+            m_pendingDocsetStamps.insert(docsetPath, stamp);
+            continue;
+        }
+
+        m_pendingDocsetStamps.remove(docsetPath);
+        m_docsetStamps.insert(docsetPath, stamp);
+        changedPaths << docsetPath;
+    }
+
+    if (!changedPaths.isEmpty()) {
+        qCDebug(log, "Loading %lld added or replaced docset(s).", static_cast<long long>(changedPaths.size()));
+
+        // Unchanged files are not a concern here, so the manifest cache is not consulted.
+        const QList<Docset *> docsets = QtConcurrent::blockingMapped(changedPaths, [](const QString &docsetPath) {
+            return constructDocset(docsetPath);
+        });
+
+        for (Docset *docset : docsets) {
+            if (docset != nullptr) {
+                registerDocset(docset);
+            }
+        }
+
+        saveManifestCache();
+    }
+
+    updateStorageWatch();
+
+    // Rescanned even if nothing else changes, since that would not be reported.
+    if (!m_pendingDocsetStamps.isEmpty()) {
+        m_storageWatchTimer->start();
+    }
+}
+
+void DocsetRegistry::updateStorageWatch()
+{
+    const QStringList watched = m_storageWatcher->directories();
+    if (!watched.isEmpty()) {
+        m_storageWatcher->removePaths(watched);
+    }
+
+    const QString storagePath = this->storagePath();
+    if (!m_isStorageWatchEnabled.load(std::memory_order_relaxed) || storagePath.isEmpty()) {
+        m_storageWatchTimer->stop();
+        return;
+    }
+
+    // Folders holding docsets report docsets being added, removed or renamed.
+    QStringList directories;
+    collectDocsetPaths(storagePath, &directories);
+
+    // Docsets that failed to load may still be being extracted. Changes to
+    // their metadata files are reported by the folders that contain them.
+    const QHash<QString, QString> loaded = loadedDocsetPaths();
+    for (auto it = m_docsetStamps.cbegin(); it != m_docsetStamps.cend(); ++it) {
+        if (loaded.contains(it.key())) {
+            continue;
+        }
+
+        static const QStringList subdirectories
+            = {QString(), QStringLiteral("/Contents"), QStringLiteral("/Contents/Resources")};
+        for (const QString &subdirectory : subdirectories) {
+            const QString directory = it.key() + subdirectory;
+            if (QFileInfo(directory).isDir()) {
+                directories << directory;
+            }
+        }
+    }
+
+    if (!directories.isEmpty()) {
+        m_storageWatcher->addPaths(directories);
+    }
+}
+
+QHash<QString, QString> DocsetRegistry::loadedDocsetPaths() const
+{
+    QHash<QString, QString> paths;
+
+    const auto current = snapshot();
+    for (const auto &docset : current->docsets) {
+        paths.insert(docset->path(), docset->name());
+    }
+
+    return paths;
+}
+
+QString DocsetRegistry::manifestCachePath() const
+{
+    return QDir(cachePath()).filePath(QStringLiteral("docsets.manifest"));
+}
+
+void DocsetRegistry::saveManifestCache() const
+{
+    if (cachePath().isEmpty()) {
+        return;
+    }
+
+    // Rewritten from the loaded docsets, which also drops removed ones.
+    ManifestCache manifestCache(manifestCachePath());
+    const auto current = snapshot();
+    for (const auto &docset : current->docsets) {
+        manifestCache.insert(docset->path(), docset->manifestEntry());
+    }
+
+    manifestCache.save();
+}
+
+QStringList DocsetRegistry::collectDocsetPaths(const QString &path, QStringList *directories)
 {
     QStringList result;
     QStack<QString> stack;
     stack.push(path);
     while (!stack.isEmpty()) {
         const QDir dir(stack.pop());
+        if (directories != nullptr) {
+            directories->append(dir.path());
+        }
+
         const auto entries = dir.entryInfoList(QDir::NoDotAndDotDot | QDir::AllDirs);
         for (const QFileInfo &entry : entries) {
+            // Docsets are installed into hidden folders first, see DocsetsDialog.
+            if (entry.fileName().startsWith(QLatin1Char('.'))) {
+                continue;
+            }
+
             if (entry.suffix() == QLatin1String("docset")) {
                 result << entry.filePath();
             } else {
@@ -299,38 +878,241 @@ void DocsetRegistry::runQuery(const QString &query)
 {
     m_cancelSearch.store(false, std::memory_order_relaxed);
 
-    QList<Docset *> enabledDocsets;
+    // Held until the query finishes, so that docsets unloaded in the meantime
+    // stay alive.
+    const auto current = snapshot();
 
     const SearchQuery searchQuery = SearchQuery::fromString(query);
+    const QString queryString = searchQuery.query();
+
+    QStringList keywords = searchQuery.keywords();
+    for (QString &keyword : keywords) {
+        keyword = keyword.toLower();
+    }
+
+    // Settings are changed from the UI thread, so they are read once for the
+    // whole query.
+    const int maxResults = this->maxResults();
+    const bool isProgressive = isProgressiveSearchEnabled();
+    const SearchMode mode{.isFuzzy = isFuzzySearchEnabled(),
+                          .isSymbolIndexEnabled = isSymbolIndexEnabled(),
+                          .isTrigramIndexEnabled = isTrigramIndexEnabled() && !cachePath().isEmpty()};
+
+    // Looked up first, since a hit needs neither the docsets nor their order.
+    const QString cacheKey = resultCacheKey(current->generation, keywords, queryString, mode, maxResults);
+    if (const auto results = cachedResults(cacheKey)) {
+        if (isProgressive) {
+            emit searchResultsAvailable(*results, true, queryString);
+        } else {
+            emit searchCompleted(*results, queryString);
+        }
+
+        return;
+    }
+
+    QList<Docset *> enabledDocsets;
     if (searchQuery.hasKeywords()) {
-        for (Docset *docset : std::as_const(m_docsets)) {
-            if (searchQuery.hasKeywords(docset->keywords())) {
-                enabledDocsets << docset;
+        for (const QString &keyword : std::as_const(keywords)) {
+            const auto it = current->docsetsByKeyword.constFind(keyword);
+            if (it == current->docsetsByKeyword.cend()) {
+                continue;
+            }
+
+            for (Docset *docset : it.value()) {
+                if (!enabledDocsets.contains(docset)) {
+                    enabledDocsets << docset;
+                }
             }
         }
     } else {
-        enabledDocsets = docsets();
+        enabledDocsets.reserve(current->docsets.size());
+        for (const auto &docset : current->docsets) {
+            enabledDocsets << docset.get();
+        }
     }
 
-    const QString queryString = searchQuery.query();
-    const QFuture<QList<SearchResult>> queryFuture = QtConcurrent::mappedReduced(enabledDocsets,
-                                                                                 [this, &queryString](Docset *docset) {
-        return docset->search(queryString, m_cancelSearch);
-    },
-                                                                                 &MergeQueryResults);
-    QList<SearchResult> results = queryFuture.result();
+    // Tasks are picked up roughly in order, so starting with the largest
+    // docsets keeps them from being the last ones still running.
+    std::ranges::stable_sort(enabledDocsets, std::ranges::greater(), searchCost);
 
-    if (m_cancelSearch.load(std::memory_order_relaxed)) {
+    // Matches for a query are a subset of the matches for any prefix of it, so
+    // while the user keeps typing only the previous candidates are rescanned.
+    // Deleting characters, changing the keyword prefix or mode, or loading and
+    // unloading docsets starts over. Only docsets searched through the symbol
+    // index have candidates, SQL searches scan the database every time.
+    const bool isRefinement = !m_querySession.query.isEmpty() && m_querySession.isFuzzy == mode.isFuzzy
+                           && m_querySession.generation == current->generation
+                           && m_querySession.keywords == keywords
+                           && queryString.startsWith(m_querySession.query, Qt::CaseInsensitive);
+
+    QList<DocsetQuery> docsetQueries;
+    docsetQueries.reserve(enabledDocsets.size());
+    for (Docset *docset : std::as_const(enabledDocsets)) {
+        DocsetQuery docsetQuery{.docset = docset, .candidates = nullptr, .matchedRows = {}, .results = {}};
+        if (isRefinement) {
+            const auto it = m_querySession.candidates.constFind(docset->name());
+            if (it != m_querySession.candidates.cend()) {
+                docsetQuery.candidates = &it.value();
+            }
+        }
+
+        docsetQueries.append(std::move(docsetQuery));
+    }
+
+    if (isRefinement) {
+        qCDebug(log, "Refining query '%s' from '%s'.", qPrintable(queryString), qPrintable(m_querySession.query));
+    }
+
+    const auto searchDocset = [this, &queryString, maxResults](DocsetQuery &docsetQuery) {
+        docsetQuery.results = docsetQuery.docset->search(queryString,
+                                                         m_cancelSearch,
+                                                         {.limit = maxResults,
+                                                          .candidates = docsetQuery.candidates,
+                                                          .matchedRows = &docsetQuery.matchedRows});
+
+        // Docsets return at most maxResults rows, so sorting them here is cheap
+        // and lets the lists be merged without a global sort.
+        std::ranges::sort(docsetQuery.results);
+    };
+
+    QList<DocsetQuery *> finishedQueries;
+    finishedQueries.reserve(docsetQueries.size());
+
+    // Merged batches already emitted in progressive mode, kept for the cache.
+    QList<QList<SearchResult>> emittedBatches;
+
+    if (isProgressive) {
+        QMutex mutex;
+        QWaitCondition docsetFinished;
+        QList<DocsetQuery *> pendingBatch;
+
+        QFuture<void> future = QtConcurrent::map(m_searchThreadPool, docsetQueries, [&](DocsetQuery &docsetQuery) {
+            searchDocset(docsetQuery);
+
+            const QMutexLocker locker(&mutex);
+            pendingBatch.append(&docsetQuery);
+            docsetFinished.wakeOne();
+        });
+
+        // Emit whatever has finished since the last batch, so that fast docsets
+        // are not held back by slow ones. After a cancellation the remaining
+        // docsets return early and are only drained.
+        bool isFirstBatch = true;
+        while (finishedQueries.size() < docsetQueries.size()) {
+            QList<DocsetQuery *> batch;
+            {
+                QMutexLocker locker(&mutex);
+                while (pendingBatch.isEmpty()) {
+                    docsetFinished.wait(&mutex);
+                }
+                batch.swap(pendingBatch);
+            }
+
+            finishedQueries.append(batch);
+
+            if (m_cancelSearch.load(std::memory_order_relaxed)) {
+                continue;
+            }
+
+            const QList<SearchResult> batchResults = mergeResults(batch, maxResults);
+            emit searchResultsAvailable(batchResults, isFirstBatch, queryString);
+            emittedBatches.append(batchResults);
+            isFirstBatch = false;
+        }
+
+        future.waitForFinished();
+
+        if (m_cancelSearch.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        // Still clear the previous results when no docset was searched.
+        if (isFirstBatch) {
+            emit searchResultsAvailable({}, true, queryString);
+        }
+    } else {
+        QtConcurrent::blockingMap(m_searchThreadPool, docsetQueries, searchDocset);
+
+        if (m_cancelSearch.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        for (DocsetQuery &docsetQuery : docsetQueries) {
+            finishedQueries.append(&docsetQuery);
+        }
+    }
+
+    QuerySession session{.query = queryString,
+                         .keywords = keywords,
+                         .isFuzzy = mode.isFuzzy,
+                         .generation = current->generation,
+                         .candidates = {}};
+
+    for (const DocsetQuery &docsetQuery : std::as_const(docsetQueries)) {
+        if (docsetQuery.matchedRows.has_value()) {
+            session.candidates.insert(docsetQuery.docset->name(), std::move(*docsetQuery.matchedRows));
+        }
+    }
+
+    // Candidate pointers into the old session are no longer in use.
+    m_querySession = std::move(session);
+
+    if (isProgressive) {
+        QList<QList<SearchResult> *> runs;
+        for (QList<SearchResult> &batchResults : emittedBatches) {
+            runs.append(&batchResults);
+        }
+
+        cacheResults(cacheKey, mergeResults(runs, maxResults));
         return;
     }
 
-    std::ranges::sort(results);
+    const QList<SearchResult> results = mergeResults(finishedQueries, maxResults);
 
     if (m_cancelSearch.load(std::memory_order_relaxed)) {
         return;
     }
 
-    emit searchCompleted(results);
+    cacheResults(cacheKey, results);
+    emit searchCompleted(results, queryString);
+}
+
+std::optional<QList<SearchResult>> DocsetRegistry::cachedResults(const QString &key)
+{
+    const QMutexLocker locker(&m_resultCacheMutex);
+
+    const QList<SearchResult> *results = m_resultCache.object(key);
+    if (results == nullptr) {
+        ++m_resultCacheMisses;
+        qCDebug(log,
+                "Result cache miss for '%s' (%llu hits, %llu misses).",
+                qPrintable(key),
+                m_resultCacheHits,
+                m_resultCacheMisses);
+        return std::nullopt;
+    }
+
+    ++m_resultCacheHits;
+    qCDebug(log,
+            "Result cache hit for '%s' (%llu hits, %llu misses).",
+            qPrintable(key),
+            m_resultCacheHits,
+            m_resultCacheMisses);
+    return *results;
+}
+
+void DocsetRegistry::cacheResults(const QString &key, const QList<SearchResult> &results)
+{
+    const QMutexLocker locker(&m_resultCacheMutex);
+
+    // Entries costlier than the whole cache are dropped by QCache.
+    m_resultCache.insert(key, new QList<SearchResult>(results), resultCacheCost(results));
+}
+
+void DocsetRegistry::invalidateResultCache()
+{
+    const QMutexLocker locker(&m_resultCacheMutex);
+    m_resultCache.clear();
 }
 
 } // namespace Zeal::Registry
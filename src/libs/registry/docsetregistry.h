@@ -7,13 +7,22 @@
 
 #include "searchresult.h"
 
+#include <QCache>
+#include <QHash>
 #include <QMap>
+#include <QMutex>
 #include <QObject>
+#include <QThread>
 
 #include <atomic>
+#include <functional>
+#include <memory>
+#include <optional>
 
 class QAbstractItemModel;
-class QThread;
+class QFileSystemWatcher;
+class QThreadPool;
+class QTimer;
 
 namespace Zeal {
 
@@ -38,9 +47,43 @@ public:
     QString storagePath() const;
     void setStoragePath(const QString &path);
 
+    // Watch the storage folder, and load or unload only the docsets that were
+    // added, removed or replaced once changes settle.
+    bool isStorageWatchEnabled() const;
+    void setStorageWatchEnabled(bool enabled);
+
     bool isFuzzySearchEnabled() const;
     void setFuzzySearchEnabled(bool enabled);
 
+    bool isSymbolIndexEnabled() const;
+    void setSymbolIndexEnabled(bool enabled);
+
+    // Directory for data derived from docsets, such as trigram indexes and the
+    // manifest cache that speeds up loading.
+    QString cachePath() const;
+    void setCachePath(const QString &path);
+
+    // Build a trigram index for each docset in the cache directory and use it
+    // for substring searches.
+    bool isTrigramIndexEnabled() const;
+    void setTrigramIndexEnabled(bool enabled);
+
+    // Maximum number of search results, 0 for unlimited.
+    int maxResults() const;
+    void setMaxResults(int count);
+
+    // Emit searchResultsAvailable() as each docset finishes instead of a
+    // single searchCompleted() once all of them have.
+    bool isProgressiveSearchEnabled() const;
+    void setProgressiveSearchEnabled(bool enabled);
+
+    // Searches run on their own thread pool, so that they do not queue behind
+    // docset loading or other work on the global one. 0 for one thread per core.
+    int searchThreadCount() const;
+    void setSearchThreadCount(int count);
+    QThread::Priority searchThreadPriority() const;
+    void setSearchThreadPriority(QThread::Priority priority);
+
     int count() const;
     bool isLoading() const;
     bool contains(const QString &name) const;
@@ -50,10 +93,15 @@ public:
     void unloadDocset(const QString &name);
     void unloadAllDocsets();
 
-    Docset *docset(const QString &name) const;
-    Docset *docset(int index) const;
-    Docset *docsetForUrl(const QUrl &url);
-    QList<Docset *> docsets() const;
+    // Lookups read the current snapshot without waiting for loading. Returned
+    // docsets stay alive while referenced, even once unloaded.
+    std::shared_ptr<Docset> docset(const QString &name) const;
+    std::shared_ptr<Docset> docset(int index) const;
+    std::shared_ptr<Docset> docsetForUrl(const QUrl &url);
+    QList<std::shared_ptr<Docset>> docsets() const;
+
+    // Lowercase keywords of all loaded docsets, sorted, for prefix completion.
+    QStringList keywords() const;
 
     void search(const QString &query);
     const QList<SearchResult> &queryResults();
@@ -64,23 +112,118 @@ signals:
     void docsetLoaded(const QString &name);
     void docsetAboutToBeUnloaded(const QString &name);
     void docsetUnloaded(const QString &name);
-    void searchCompleted(const QList<Zeal::Registry::SearchResult> &results);
+    // The query is the one results were matched against, without keywords.
+    void searchCompleted(const QList<Zeal::Registry::SearchResult> &results, const QString &query);
+    // Sorted results of the docsets that finished since the previous batch. The
+    // first batch of a query replaces the previous results, later ones are merged.
+    void searchResultsAvailable(const QList<Zeal::Registry::SearchResult> &results,
+                                bool isFirstBatch,
+                                const QString &query);
 
 private:
+    // Immutable set of loaded docsets. Loading and unloading publish a new
+    // snapshot, while searches keep using the one they started with, along
+    // with its docsets, until they finish.
+    struct Snapshot
+    {
+        QMap<QString, std::shared_ptr<Docset>> docsets;
+        // Routes keyword prefixed queries without asking every docset.
+        QHash<QString, QList<Docset *>> docsetsByKeyword;
+        quint64 generation = 0; // Incremented with every published snapshot.
+    };
+
+    std::shared_ptr<const Snapshot> snapshot() const;
+    // Applies update to a copy of the current snapshot and publishes it.
+    void updateSnapshot(const std::function<void(Snapshot &)> &update);
+
     void addDocsetsFromFolder(const QString &path);
-    static QStringList collectDocsetPaths(const QString &path);
+    void syncDocsetsFromFolder(const QString &path);
+    void updateStorageWatch();
+    QHash<QString, QString> loadedDocsetPaths() const;
+    // Also returns the folders searched for docsets in directories.
+    static QStringList collectDocsetPaths(const QString &path, QStringList *directories = nullptr);
     void registerDocset(Docset *docset);
+    // The caller must hold m_registrationMutex.
+    void unloadDocsetLocked(const QString &name);
+    QString manifestCachePath() const;
+    void saveManifestCache() const;
+    QString trigramIndexPath(const QString &name) const;
+    // Sidecar name index for docsets on read-only storage.
+    QString nameIndexPath(const QString &name) const;
+    void updateTrigramIndexes();
     void runQuery(const QString &query);
 
+    std::optional<QList<SearchResult>> cachedResults(const QString &key);
+    void cacheResults(const QString &key, const QList<SearchResult> &results);
+    void invalidateResultCache();
+
     QAbstractItemModel *m_model = nullptr;
 
     Core::HttpServer *m_httpServer = nullptr;
 
+    // Settings are changed from the UI thread while the search and loader
+    // threads read them.
+    mutable QMutex m_pathMutex;
     QString m_storagePath;
-    bool m_isFuzzySearchEnabled = false;
+    QString m_cachePath;
+    std::atomic_bool m_isFuzzySearchEnabled{false};
+    std::atomic_bool m_isSymbolIndexEnabled{false};
+    std::atomic_bool m_isTrigramIndexEnabled{false};
+    std::atomic_int m_maxResults{0};
+    std::atomic_bool m_isProgressiveSearchEnabled{false};
 
     QThread *m_thread = nullptr;
-    QMap<QString, Docset *> m_docsets;
+    QThreadPool *m_searchThreadPool = nullptr;
+    int m_searchThreadCount = 0;
+
+    // Folder loading runs here, so that it does not hold up searches.
+    QThread *m_loaderThread = nullptr;
+    QObject *m_loader = nullptr;
+
+    // Live on the loader thread, like the stamps below.
+    QFileSystemWatcher *m_storageWatcher = nullptr;
+    QTimer *m_storageWatchTimer = nullptr;
+    std::atomic_bool m_isStorageWatchEnabled{false};
+    // File stamps of docsets found in the storage folder when they were last
+    // loaded, including those that failed to load, keyed by docset path.
+    QHash<QString, QList<qint64>> m_docsetStamps;
+    // Stamps of changed docsets seen by the last scan, not loaded until a
+    // scan finds them unchanged.
+    QHash<QString, QList<qint64>> m_pendingDocsetStamps;
+
+    // The mutex only guards copying and swapping the pointer, snapshots are
+    // built outside of it, so readers wait for at most a pointer copy. The
+    // atomic shared_ptr functions are deprecated in C++20, and libc++ has no
+    // std::atomic<std::shared_ptr>. Writers are serialized by m_writeMutex.
+    mutable QMutex m_snapshotMutex;
+    std::shared_ptr<const Snapshot> m_snapshot;
+    QMutex m_writeMutex;
+
+    // Held from checking whether a docset is loaded until it has been
+    // registered or unloaded. Locked before m_writeMutex.
+    QMutex m_registrationMutex;
+
+    // Rows matched by the last completed query, per docset. A query that only
+    // appends to it can only match a subset, so the next scan is narrowed to them.
+    struct QuerySession
+    {
+        QString query;
+        QStringList keywords;
+        bool isFuzzy = false;
+        quint64 generation = 0; // Of the snapshot the rows belong to.
+        QHash<QString, QList<int>> candidates;
+    };
+
+    QuerySession m_querySession;
+
+    // Final results of recent queries, so that deleting or retyping characters
+    // does not rescan docsets. Keys include the snapshot generation, which
+    // changes whenever a docset is loaded or unloaded, and the search backends.
+    // Costs are in KiB.
+    QMutex m_resultCacheMutex;
+    QCache<QString, QList<SearchResult>> m_resultCache;
+    quint64 m_resultCacheHits = 0;
+    quint64 m_resultCacheMisses = 0;
 
     std::atomic_bool m_isLoadingDocsets{false};
     std::atomic_bool m_cancelSearch{false};
@@ -0,0 +1,88 @@
+// Copyright (C) Oleg Shparber, et al. <https://zealdocs.org>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "indexbuild.h"
+
+#include <util/database.h>
+#include <util/statement.h>
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+#include <QThreadPool>
+
+namespace Zeal::Registry::IndexBuild {
+
+namespace {
+using Qt::Literals::StringLiterals::operator""_L1;
+
+constexpr auto FormatKey = "format"_L1;
+constexpr auto SourceSizeKey = "source_size"_L1;
+constexpr auto SourceModifiedKey = "source_modified"_L1;
+} // namespace
+
+QThreadPool *threadPool()
+{
+    static QThreadPool *pool = [] {
+        auto *pool = new QThreadPool();
+        pool->setMaxThreadCount(1);
+        pool->setThreadPriority(QThread::LowestPriority);
+        return pool;
+    }();
+    return pool;
+}
+
+QList<qint64> fileStamp(const QString &path)
+{
+    const QFileInfo fi(path);
+    if (!fi.exists()) {
+        return {-1, -1};
+    }
+
+    return {fi.size(), fi.lastModified().toMSecsSinceEpoch()};
+}
+
+QString createMetaTableQuery()
+{
+    return QStringLiteral("CREATE TABLE IF NOT EXISTS meta (key TEXT PRIMARY KEY, value TEXT)");
+}
+
+QString setMetaQuery(QLatin1StringView key, const QString &value)
+{
+    return QStringLiteral("INSERT OR REPLACE INTO meta VALUES ('%1', '%2')").arg(key, value);
+}
+
+QStringList setSourceMetaQueries(int formatVersion, const QList<qint64> &sourceStamp)
+{
+    return {setMetaQuery(FormatKey, QString::number(formatVersion)),
+            setMetaQuery(SourceSizeKey, QString::number(sourceStamp.value(0))),
+            setMetaQuery(SourceModifiedKey, QString::number(sourceStamp.value(1)))};
+}
+
+QHash<QString, QString> readMeta(const QString &path)
+{
+    // Opening a missing file with SQLite would create it.
+    if (!QFile::exists(path)) {
+        return {};
+    }
+
+    Util::Database db(path);
+    Util::Statement stmt(db, QStringLiteral("SELECT key, value FROM meta"));
+
+    QHash<QString, QString> values;
+    while (stmt.step()) {
+        values.insert(stmt.value(0).toString(), stmt.value(1).toString());
+    }
+
+    return values;
+}
+
+bool isSourceMetaCurrent(const QHash<QString, QString> &meta, int formatVersion, const QList<qint64> &sourceStamp)
+{
+    return meta.value(FormatKey) == QString::number(formatVersion)
+           && meta.value(SourceSizeKey) == QString::number(sourceStamp.value(0))
+           && meta.value(SourceModifiedKey) == QString::number(sourceStamp.value(1));
+}
+
+} // namespace Zeal::Registry::IndexBuild
@@ -0,0 +1,35 @@
+// Copyright (C) Oleg Shparber, et al. <https://zealdocs.org>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef ZEAL_REGISTRY_INDEXBUILD_H
+#define ZEAL_REGISTRY_INDEXBUILD_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+class QThreadPool;
+
+namespace Zeal::Registry::IndexBuild {
+
+// Shared by name, trigram and symbol index builds, which compete with searches
+// for the disk. Builds run one at a time and behind everything else, in the
+// order they were started.
+QThreadPool *threadPool();
+
+// Size and modification time of a file, or -1 for both if it is missing.
+QList<qint64> fileStamp(const QString &path);
+
+// Sidecar databases have a meta table of key-value pairs, recording their
+// format and the stamp of the docset database they were built from.
+QString createMetaTableQuery();
+QString setMetaQuery(QLatin1StringView key, const QString &value);
+QStringList setSourceMetaQueries(int formatVersion, const QList<qint64> &sourceStamp);
+
+QHash<QString, QString> readMeta(const QString &path);
+bool isSourceMetaCurrent(const QHash<QString, QString> &meta, int formatVersion, const QList<qint64> &sourceStamp);
+
+} // namespace Zeal::Registry::IndexBuild
+
+#endif // ZEAL_REGISTRY_INDEXBUILD_H
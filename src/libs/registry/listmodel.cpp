@@ -11,6 +11,7 @@
 #include <QLocale>
 
 #include <iterator>
+#include <utility>
 
 namespace Zeal::Registry {
 
@@ -102,8 +103,12 @@ QVariant ListModel::data(const QModelIndex &index, int role) const
             return {};
         }
 
-        auto *const docset = itemInRow(index.row())->docset;
+        const Docset *docset = itemInRow(index.row())->docset.get();
         QString tooltip = tr("Version: %1r%2").arg(docset->version()).arg(docset->revision());
+        if (const int progress = docset->nameIndexProgress(); progress >= 0) {
+            tooltip += QLatin1Char('\n') + tr("Indexing: %1%").arg(progress);
+        }
+
         if (const auto &update = docset->update()) {
             if (update->size > 0) {
                 tooltip += QLatin1Char('\n')
@@ -200,7 +205,7 @@ int ListModel::rowCount(const QModelIndex &parent) const
     case IndexLevel::Root:
         return static_cast<int>(m_docsetItems.size());
     case IndexLevel::Docset:
-        return static_cast<int>(itemInRow(parent.row())->docset->symbolCounts().count());
+        return static_cast<int>(itemInRow(parent.row())->groups.size());
     case IndexLevel::Group: {
         auto *docsetItem = static_cast<DocsetItem *>(parent.internalPointer());
         return docsetItem->docset->symbolCount(docsetItem->groups.at(parent.row())->symbolType);
@@ -210,19 +215,38 @@ int ListModel::rowCount(const QModelIndex &parent) const
     }
 }
 
-void ListModel::addDocset(const QString &name)
+bool ListModel::hasChildren(const QModelIndex &parent) const
 {
-    if (m_docsetItems.contains(name)) {
-        return;
+    // Assume symbols until fetched, so that docsets can be expanded.
+    if (parent.column() <= 0 && indexLevel(parent) == IndexLevel::Docset) {
+        const DocsetItem *docsetItem = itemInRow(parent.row());
+        return !docsetItem->hasGroups || !docsetItem->groups.isEmpty();
     }
 
-    const int row = static_cast<int>(std::distance(m_docsetItems.begin(), m_docsetItems.upper_bound(name)));
-    beginInsertRows(QModelIndex(), row, row);
+    return QAbstractItemModel::hasChildren(parent);
+}
 
-    auto *docsetItem = new DocsetItem();
-    docsetItem->docset = m_docsetRegistry->docset(name);
+bool ListModel::canFetchMore(const QModelIndex &parent) const
+{
+    return parent.column() <= 0 && indexLevel(parent) == IndexLevel::Docset && !itemInRow(parent.row())->hasGroups;
+}
+
+void ListModel::fetchMore(const QModelIndex &parent)
+{
+    if (!canFetchMore(parent)) {
+        return;
+    }
+
+    DocsetItem *docsetItem = itemInRow(parent.row());
+    docsetItem->hasGroups = true;
 
     const auto keys = docsetItem->docset->symbolCounts().keys();
+    if (keys.isEmpty()) {
+        return;
+    }
+
+    beginInsertRows(parent, 0, static_cast<int>(keys.size()) - 1);
+
     for (const QString &symbolType : keys) {
         auto *groupItem = new GroupItem();
         groupItem->docsetItem = docsetItem;
@@ -230,6 +254,27 @@ void ListModel::addDocset(const QString &name)
         docsetItem->groups.append(groupItem);
     }
 
+    endInsertRows();
+}
+
+void ListModel::addDocset(const QString &name)
+{
+    if (m_docsetItems.contains(name)) {
+        return;
+    }
+
+    // Loading runs on another thread, the docset may be gone by now.
+    std::shared_ptr<Docset> docset = m_docsetRegistry->docset(name);
+    if (docset == nullptr) {
+        return;
+    }
+
+    const int row = static_cast<int>(std::distance(m_docsetItems.begin(), m_docsetItems.upper_bound(name)));
+    beginInsertRows(QModelIndex(), row, row);
+
+    auto *docsetItem = new DocsetItem();
+    docsetItem->docset = std::move(docset);
+
     m_docsetItems.insert({name, docsetItem});
     m_docsetRows.insert(m_docsetRows.begin() + row, docsetItem);
     int rowIndex = 0;
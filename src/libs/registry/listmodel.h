@@ -9,6 +9,7 @@
 
 #include <QAbstractItemModel>
 
+#include <memory>
 #include <vector>
 
 namespace Zeal::Registry {
@@ -30,6 +31,12 @@ public:
     QModelIndex parent(const QModelIndex &child) const override;
     int columnCount(const QModelIndex &parent) const override;
     int rowCount(const QModelIndex &parent) const override;
+    bool hasChildren(const QModelIndex &parent) const override;
+
+    // Symbol groups are fetched when a docset is expanded, since counting
+    // symbols opens the docset database.
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
 
 private:
     friend class DocsetRegistry;
@@ -81,8 +88,10 @@ private:
         {
         }
 
-        Docset *docset = nullptr;
+        // Shared with the registry, so that an unloaded docset outlives its row.
+        std::shared_ptr<Docset> docset;
         QList<GroupItem *> groups;
+        bool hasGroups = false; // Whether groups have been fetched.
         int row = 0;
     };
 
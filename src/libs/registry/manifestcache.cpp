@@ -0,0 +1,181 @@
+// Copyright (C) Oleg Shparber, et al. <https://zealdocs.org>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "manifestcache.h"
+
+#include "indexbuild.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLoggingCategory>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <utility>
+
+namespace Zeal::Registry {
+
+namespace {
+Q_LOGGING_CATEGORY(log, "zeal.registry.manifestcache")
+
+using Qt::Literals::StringLiterals::operator""_L1;
+
+constexpr quint32 Magic = 0x5a4d4346; // "ZMCF"
+// Bump when the layout of the file or of Docset::ManifestEntry changes.
+constexpr quint32 FormatVersion = 2;
+constexpr auto StreamVersion = QDataStream::Qt_6_0;
+
+constexpr auto DatabaseFile = "Contents/Resources/docSet.dsidx"_L1;
+
+// Files loading reads, relative to the docset directory. Both plist spellings
+// are listed, since either may be used. The database comes last.
+const QStringList &stampedFiles()
+{
+    static const QStringList files = {QStringLiteral("meta.json"),
+                                      QStringLiteral("Contents/Info.plist"),
+                                      QStringLiteral("Contents/info.plist"),
+                                      QString(DatabaseFile)};
+    return files;
+}
+
+QDataStream &operator<<(QDataStream &out, const Docset::ManifestEntry &entry)
+{
+    return out << entry.name << entry.title << entry.keywords << entry.version << entry.revision << entry.feedUrl
+               << entry.iconPath << entry.indexFilePath << entry.isJavaScriptEnabled << entry.hasSymbolCounts
+               << entry.symbolStrings << entry.symbolCounts << entry.fileStamp;
+}
+
+QDataStream &operator>>(QDataStream &in, Docset::ManifestEntry &entry)
+{
+    return in >> entry.name >> entry.title >> entry.keywords >> entry.version >> entry.revision >> entry.feedUrl
+           >> entry.iconPath >> entry.indexFilePath >> entry.isJavaScriptEnabled >> entry.hasSymbolCounts
+           >> entry.symbolStrings >> entry.symbolCounts >> entry.fileStamp;
+}
+} // namespace
+
+ManifestCache::ManifestCache(QString path)
+    : m_path(std::move(path))
+{
+}
+
+bool ManifestCache::load()
+{
+    m_entries.clear();
+
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(StreamVersion);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if (magic != Magic || version != FormatVersion) {
+        qCDebug(log, "Ignoring manifest cache '%s' of another format.", qPrintable(m_path));
+        return false;
+    }
+
+    qint32 count = 0;
+    in >> count;
+
+    QHash<QString, Docset::ManifestEntry> entries;
+    for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QString docsetPath;
+        Docset::ManifestEntry entry;
+        in >> docsetPath >> entry;
+        entries.insert(docsetPath, std::move(entry));
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        qCWarning(log, "Cannot read manifest cache '%s', ignoring it.", qPrintable(m_path));
+        return false;
+    }
+
+    m_entries = std::move(entries);
+    return true;
+}
+
+bool ManifestCache::save() const
+{
+    QDir().mkpath(QFileInfo(m_path).absolutePath());
+
+    // Written to a temporary file and renamed, so that a crash never leaves a
+    // truncated cache behind.
+    QSaveFile file(m_path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(log, "Cannot write manifest cache '%s': %s", qPrintable(m_path), qPrintable(file.errorString()));
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(StreamVersion);
+
+    out << Magic << FormatVersion << static_cast<qint32>(m_entries.size());
+    for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it) {
+        out << it.key() << it.value();
+    }
+
+    if (out.status() != QDataStream::Ok || !file.commit()) {
+        qCWarning(log, "Cannot write manifest cache '%s': %s", qPrintable(m_path), qPrintable(file.errorString()));
+        return false;
+    }
+
+    return true;
+}
+
+std::optional<Docset::ManifestEntry> ManifestCache::entry(const QString &docsetPath) const
+{
+    const auto it = m_entries.constFind(docsetPath);
+    if (it == m_entries.cend() || it->fileStamp != fileStamp(docsetPath)) {
+        return std::nullopt;
+    }
+
+    return it.value();
+}
+
+void ManifestCache::insert(const QString &docsetPath, const Docset::ManifestEntry &entry)
+{
+    // Stamping here instead would hide changes made after the docset was read.
+    if (entry.fileStamp.isEmpty()) {
+        return;
+    }
+
+    m_entries.insert(docsetPath, entry);
+}
+
+void ManifestCache::clear()
+{
+    m_entries.clear();
+}
+
+QList<qint64> ManifestCache::fileStamp(const QString &docsetPath)
+{
+    const QDir dir(docsetPath);
+
+    QList<qint64> stamp;
+    stamp.reserve(2 * stampedFiles().size());
+    for (const QString &fileName : stampedFiles()) {
+        stamp << IndexBuild::fileStamp(dir.filePath(fileName));
+    }
+
+    return stamp;
+}
+
+bool ManifestCache::restampDatabase(QList<qint64> *stamp, const QString &docsetPath, const QList<qint64> &previousStamp)
+{
+    const qsizetype offset = 2 * (stampedFiles().size() - 1);
+    if (stamp->size() != 2 * stampedFiles().size() || stamp->mid(offset) != previousStamp) {
+        return false;
+    }
+
+    const QList<qint64> databaseStamp = IndexBuild::fileStamp(QDir(docsetPath).filePath(DatabaseFile));
+    std::copy(databaseStamp.cbegin(), databaseStamp.cend(), stamp->begin() + offset);
+    return true;
+}
+
+} // namespace Zeal::Registry
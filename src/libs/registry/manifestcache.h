@@ -0,0 +1,55 @@
+// Copyright (C) Oleg Shparber, et al. <https://zealdocs.org>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef ZEAL_REGISTRY_MANIFESTCACHE_H
+#define ZEAL_REGISTRY_MANIFESTCACHE_H
+
+#include "docset.h"
+
+#include <QHash>
+#include <QList>
+#include <QString>
+
+#include <optional>
+
+namespace Zeal::Registry {
+
+// Binary cache of docset manifest entries, so that startup does not parse
+// meta.json and Info.plist or count symbols of docsets that have not changed.
+//
+// Entries are keyed by docset path and carry the size and modification time of
+// meta.json, Info.plist and docSet.dsidx taken when the docset was read, see
+// Docset::ManifestEntry::fileStamp. An entry whose files have changed since is
+// ignored.
+class ManifestCache final
+{
+public:
+    explicit ManifestCache(QString path);
+
+    // Returns false if the file is missing, unreadable or of another format.
+    bool load();
+    bool save() const;
+
+    std::optional<Docset::ManifestEntry> entry(const QString &docsetPath) const;
+    // Entries without a file stamp are not inserted.
+    void insert(const QString &docsetPath, const Docset::ManifestEntry &entry);
+    void clear();
+
+    // Size and modification time of the files loading reads, for telling
+    // whether a docset has changed.
+    static QList<qint64> fileStamp(const QString &docsetPath);
+
+    // Brings the docset database part of a fileStamp() up to date after the
+    // app itself has written to the database, e.g. to add an index. Returns
+    // false and leaves stamp as it is if that part was not previousStamp, since
+    // the database had then been changed by something else.
+    static bool restampDatabase(QList<qint64> *stamp, const QString &docsetPath, const QList<qint64> &previousStamp);
+
+private:
+    QString m_path;
+    QHash<QString, Docset::ManifestEntry> m_entries;
+};
+
+} // namespace Zeal::Registry
+
+#endif // ZEAL_REGISTRY_MANIFESTCACHE_H
@@ -0,0 +1,496 @@
+// Copyright (C) Oleg Shparber, et al. <https://zealdocs.org>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "nameindex.h"
+
+#include "indexbuild.h"
+
+#include <util/database.h>
+#include <util/statement.h>
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QLoggingCategory>
+#include <QMutexLocker>
+#include <QScopeGuard>
+#include <QtConcurrent>
+
+#include <sqlite3.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace Zeal::Registry {
+
+namespace {
+Q_LOGGING_CATEGORY(log, "zeal.registry.nameindex")
+
+using Qt::Literals::StringLiterals::operator""_L1;
+
+constexpr auto IndexNamePrefix = "__zi_name"_L1; // zi - Zeal index
+constexpr auto IndexNameVersion = "0001"_L1;     // Current index version
+
+// Flat copy of the ZDash searchIndex join, see NameIndex::materializeSymbols().
+constexpr auto SymbolTablePrefix = "__zi_symbols"_L1;
+constexpr auto SymbolTableVersion = "0001"_L1; // Bump when the table layout changes.
+
+// Bump when the sidecar schema changes, so existing files are rebuilt.
+constexpr int SidecarFormatVersion = 1;
+
+constexpr auto CompleteKey = "complete"_L1;
+
+// Rows copied into a sidecar or a symbol table per transaction. Committed
+// batches survive an interrupted build.
+constexpr int BatchSize = 50000;
+
+// Number of VM instructions between progress updates of an in-place build.
+constexpr int ProgressInterval = 1000;
+// CREATE INDEX reads every row into a sorter and then inserts it into the
+// index, which takes roughly this many VM instructions per row.
+constexpr int EstimatedStepsPerRow = 12;
+
+// An in-place build needs searches on the docset connection to finish before
+// it can commit, which they in turn wait for.
+constexpr int BusyTimeout = 10000; // ms
+
+// Pages of the new index kept in memory before they are written to the file,
+// which locks out readers until the commit. 64 MiB at the default page size.
+constexpr int MaxCachedBuildPages = 16384;
+
+qint64 queryValue(Util::Database &db, const QString &sql)
+{
+    Util::Statement stmt(db, sql);
+    return stmt.step() ? stmt.value(0).toLongLong() : 0;
+}
+
+QString symbolTableName()
+{
+    return SymbolTablePrefix + SymbolTableVersion;
+}
+
+// Copies the next batch of the ZDash symbol join from schema (empty or
+// "source.") into target, keyed by ztoken.z_pk. The %3 and %4 placeholders
+// are left for the last copied id and the batch size.
+QString symbolBatchQuery(const QString &target, const QString &schema)
+{
+    return QStringLiteral("INSERT INTO %1"
+                          "  SELECT ztoken.z_pk, ztokenname, ztypename, zpath, zanchor"
+                          "  FROM %2ztoken"
+                          "  INNER JOIN %2ztokenmetainformation"
+                          "    ON ztoken.zmetainformation = ztokenmetainformation.z_pk"
+                          "  INNER JOIN %2zfilepath"
+                          "    ON ztokenmetainformation.zfile = zfilepath.z_pk"
+                          "  INNER JOIN %2ztokentype"
+                          "    ON ztoken.ztokentype = ztokentype.z_pk"
+                          "  WHERE ztoken.z_pk > %3"
+                          "  ORDER BY ztoken.z_pk"
+                          "  LIMIT %4")
+        .arg(target, schema);
+}
+} // namespace
+
+NameIndex::NameIndex(const QString &docsetName,
+                     const QString &sourcePath,
+                     bool isZDash,
+                     const QString &sidecarPath,
+                     SourceWrittenHandler sourceWrittenHandler)
+    : m_docsetName(docsetName)
+    , m_sourcePath(sourcePath)
+    , m_isZDash(isZDash)
+    , m_sidecarPath(sidecarPath)
+    , m_sourceWrittenHandler(std::move(sourceWrittenHandler))
+{
+    m_buildFuture = QtConcurrent::run(IndexBuild::threadPool(), [this]() {
+        build();
+    });
+}
+
+NameIndex::~NameIndex()
+{
+    m_isBuildCanceled.store(true, std::memory_order_relaxed);
+
+    {
+        const QMutexLocker locker(&m_buildMutex);
+        if (m_buildDb != nullptr) {
+            sqlite3_interrupt(m_buildDb->handle());
+        }
+    }
+
+    m_buildFuture.waitForFinished();
+}
+
+bool NameIndex::isReady() const
+{
+    return m_isReady.load(std::memory_order_acquire);
+}
+
+int NameIndex::progress() const
+{
+    return m_progress.load(std::memory_order_relaxed);
+}
+
+bool NameIndex::attach(Util::Database *db) const
+{
+    if (!isReady()) {
+        return false;
+    }
+
+    if (m_sidecarPath.isEmpty()) {
+        // The docset connection searches ZDash docsets through a temporary
+        // join view until the symbol table is materialized.
+        return !m_isZDash || db->execute(QStringLiteral("DROP VIEW IF EXISTS temp.searchIndex"));
+    }
+
+    Util::Statement stmt(*db, QStringLiteral("ATTACH DATABASE ? AS nameindex"));
+    stmt.bindText(1, m_sidecarPath);
+    if (!stmt.step() && !stmt.lastError().isEmpty()) {
+        qCWarning(log, "[%s] Cannot attach name index: %s", qPrintable(m_docsetName), qPrintable(stmt.lastError()));
+        return false;
+    }
+
+    // Unqualified names resolve to the temp schema first, so the view takes
+    // the place of searchIndex in all docset queries. Swapped in a single
+    // transaction, so that a failed attach leaves the connection as it was.
+    const bool ok = db->execute(QStringLiteral("BEGIN"))
+                    && db->execute(QStringLiteral("DROP VIEW IF EXISTS temp.searchIndex"))
+                    && db->execute(QStringLiteral("CREATE TEMP VIEW searchIndex AS"
+                                                  "  SELECT name, type, path, fragment FROM nameindex.symbols"))
+                    && db->execute(QStringLiteral("COMMIT"));
+    if (!ok) {
+        qCWarning(log, "[%s] Cannot use name index: %s", qPrintable(m_docsetName), qPrintable(db->lastError()));
+        db->execute(QStringLiteral("ROLLBACK"));
+        db->execute(QStringLiteral("DETACH DATABASE nameindex"));
+    }
+
+    return ok;
+}
+
+void NameIndex::build()
+{
+    const bool ok = m_sidecarPath.isEmpty() ? buildInPlace() : buildSidecar();
+
+    m_progress.store(-1, std::memory_order_relaxed);
+
+    if (ok && !isCanceled()) {
+        m_isReady.store(true, std::memory_order_release);
+    }
+}
+
+bool NameIndex::buildInPlace()
+{
+    // ZDash docsets are searched through the materialized symbol table.
+    const QString tableName = m_isZDash ? symbolTableName() : QStringLiteral("searchIndex");
+
+    // Reported once the database is closed, including batches committed by
+    // a build that failed later on.
+    const QList<qint64> sourceStamp = IndexBuild::fileStamp(m_sourcePath);
+    const auto sourceWrittenGuard = qScopeGuard([this, &sourceStamp]() {
+        if (m_sourceWrittenHandler && IndexBuild::fileStamp(m_sourcePath) != sourceStamp) {
+            m_sourceWrittenHandler(sourceStamp);
+        }
+    });
+
+    Util::Database db(m_sourcePath, {.busyTimeout = BusyTimeout});
+    if (!db.isOpen()) {
+        qCWarning(log, "[%s] Cannot open database: %s", qPrintable(m_docsetName), qPrintable(db.lastError()));
+        return false;
+    }
+
+    // Keep the new index in memory until the commit where it fits, spilling
+    // it to the file would lock out readers for the rest of the build.
+    db.execute(QStringLiteral("PRAGMA cache_spill = %1").arg(MaxCachedBuildPages));
+
+    {
+        const QMutexLocker locker(&m_buildMutex);
+        m_buildDb = &db;
+    }
+
+    const auto buildDbGuard = qScopeGuard([this]() {
+        const QMutexLocker locker(&m_buildMutex);
+        m_buildDb = nullptr;
+    });
+
+    if (m_isZDash && !materializeSymbols(db)) {
+        return false;
+    }
+
+    // Earlier versions indexed ztoken, which searches do not read.
+    QStringList indexedTables = {tableName};
+    if (m_isZDash) {
+        indexedTables << QStringLiteral("ztoken");
+    }
+
+    QStringList oldIndexes;
+    for (const QString &indexedTable : std::as_const(indexedTables)) {
+        Util::Statement stmt(db, QStringLiteral("PRAGMA INDEX_LIST('%1')").arg(indexedTable));
+        while (stmt.step()) {
+            const QString indexName = stmt.value(1).toString();
+            if (!indexName.startsWith(IndexNamePrefix)) {
+                continue;
+            }
+
+            if (indexedTable == tableName && indexName.endsWith(IndexNameVersion)) {
+                return true;
+            }
+
+            oldIndexes << indexName;
+        }
+    }
+
+    qCDebug(log, "[%s] Building name index.", qPrintable(m_docsetName));
+
+    QElapsedTimer timer;
+    timer.start();
+
+    m_buildSteps = 0;
+    m_buildStartProgress = std::max(0, progress());
+    m_estimatedBuildSteps
+        = EstimatedStepsPerRow * queryValue(db, QStringLiteral("SELECT max(rowid) FROM %1").arg(tableName));
+    m_progress.store(m_buildStartProgress, std::memory_order_relaxed);
+
+    sqlite3_progress_handler(db.handle(), ProgressInterval, progressCallback, this);
+
+    // Old indexes are dropped in the same transaction, so that they stay in
+    // use if the build is interrupted.
+    bool ok = db.execute(QStringLiteral("BEGIN"));
+    for (const QString &oldIndexName : std::as_const(oldIndexes)) {
+        ok = ok && db.execute(QStringLiteral("DROP INDEX '%1'").arg(oldIndexName));
+    }
+
+    ok = ok
+         && db.execute(QStringLiteral("CREATE INDEX IF NOT EXISTS %1%2 ON %3 (name COLLATE NOCASE)")
+                           .arg(IndexNamePrefix, IndexNameVersion, tableName))
+         && db.execute(QStringLiteral("COMMIT"));
+
+    // Cleared first, so that a canceled build can still roll back.
+    sqlite3_progress_handler(db.handle(), 0, nullptr, nullptr);
+
+    if (!ok) {
+        const QString error = db.lastError();
+        db.execute(QStringLiteral("ROLLBACK"));
+
+        if (!isCanceled()) {
+            qCWarning(log, "[%s] Cannot build name index: %s", qPrintable(m_docsetName), qPrintable(error));
+        }
+
+        return false;
+    }
+
+    qCDebug(log, "[%s] Built name index in %lld ms.", qPrintable(m_docsetName), timer.elapsed());
+    return true;
+}
+
+bool NameIndex::buildSidecar()
+{
+    const QList<qint64> sourceStamp = IndexBuild::fileStamp(m_sourcePath);
+
+    // A sidecar of another format or of a replaced docset starts over, an
+    // incomplete one resumes.
+    const QHash<QString, QString> meta = IndexBuild::readMeta(m_sidecarPath);
+    if (!IndexBuild::isSourceMetaCurrent(meta, SidecarFormatVersion, sourceStamp)) {
+        QFile::remove(m_sidecarPath);
+    } else if (meta.value(CompleteKey) == QLatin1String("1")) {
+        return true;
+    }
+
+    QDir().mkpath(QFileInfo(m_sidecarPath).absolutePath());
+
+    Util::Database db(m_sidecarPath);
+    {
+        const QMutexLocker locker(&m_buildMutex);
+        m_buildDb = &db;
+    }
+
+    const auto buildDbGuard = qScopeGuard([this]() {
+        const QMutexLocker locker(&m_buildMutex);
+        m_buildDb = nullptr;
+    });
+
+    const auto execute = [this, &db](const QString &sql) {
+        return !isCanceled() && db.execute(sql);
+    };
+
+    Util::Statement attach(db, QStringLiteral("ATTACH DATABASE ? AS source"));
+    attach.bindText(1, m_sourcePath);
+
+    bool ok = db.isOpen()
+              && execute(QStringLiteral("CREATE TABLE IF NOT EXISTS symbols"
+                                        "  (id INTEGER PRIMARY KEY, name TEXT, type TEXT, path TEXT, fragment TEXT)"))
+              && execute(QStringLiteral("CREATE INDEX IF NOT EXISTS symbols_name ON symbols (name COLLATE NOCASE)"))
+              && execute(IndexBuild::createMetaTableQuery())
+              && std::ranges::all_of(IndexBuild::setSourceMetaQueries(SidecarFormatVersion, sourceStamp), execute)
+              && (attach.step() || attach.lastError().isEmpty());
+
+    // Rows are copied in source id order, so the largest copied id is where
+    // the next batch starts.
+    const QString batchQuery = m_isZDash ? symbolBatchQuery(QStringLiteral("symbols"), QStringLiteral("source."))
+                                         : QStringLiteral("INSERT INTO symbols"
+                                                          "  SELECT rowid, name, type, path, ''"
+                                                          "  FROM source.searchIndex"
+                                                          "  WHERE rowid > %1"
+                                                          "  ORDER BY rowid"
+                                                          "  LIMIT %2");
+
+    const qint64 lastId = ok ? queryValue(db,
+                                          m_isZDash ? QStringLiteral("SELECT max(z_pk) FROM source.ztoken")
+                                                    : QStringLiteral("SELECT max(rowid) FROM source.searchIndex"))
+                             : 0;
+    qint64 copiedId = ok ? queryValue(db, QStringLiteral("SELECT coalesce(max(id), 0) FROM symbols")) : 0;
+
+    if (ok) {
+        qCDebug(log,
+                "[%s] Building name index at '%s' from row %lld.",
+                qPrintable(m_docsetName),
+                qPrintable(m_sidecarPath),
+                copiedId);
+    }
+
+    while (ok && copiedId < lastId) {
+        m_progress.store(static_cast<int>(100 * copiedId / lastId), std::memory_order_relaxed);
+
+        ok = execute(QStringLiteral("BEGIN")) && execute(batchQuery.arg(copiedId).arg(BatchSize))
+             && execute(QStringLiteral("COMMIT"));
+
+        const qint64 id = queryValue(db, QStringLiteral("SELECT coalesce(max(id), 0) FROM symbols"));
+        if (id == copiedId) {
+            break; // Only rows without a match in the join are left.
+        }
+
+        copiedId = id;
+    }
+
+    ok = ok && execute(IndexBuild::setMetaQuery(CompleteKey, QStringLiteral("1")));
+
+    if (!ok) {
+        const QString error = !attach.lastError().isEmpty() ? attach.lastError() : db.lastError();
+        db.execute(QStringLiteral("ROLLBACK"));
+
+        if (!isCanceled()) {
+            qCWarning(log, "[%s] Cannot build name index: %s", qPrintable(m_docsetName), qPrintable(error));
+        }
+
+        return false;
+    }
+
+    qCDebug(log, "[%s] Name index is ready.", qPrintable(m_docsetName));
+    return true;
+}
+
+bool NameIndex::materializeSymbols(Util::Database &db)
+{
+    const QString tableName = symbolTableName();
+
+    // The searchIndex view is only pointed at the table once it is complete.
+    {
+        Util::Statement stmt(db,
+                             QStringLiteral("SELECT sql FROM sqlite_master"
+                                            "  WHERE type = 'view' AND name = 'searchIndex'"));
+        if (stmt.step() && stmt.value(0).toString().contains(tableName)) {
+            return true;
+        }
+    }
+
+    QStringList oldTables;
+    const QStringList tables = db.tables();
+    for (const QString &table : tables) {
+        if (table.startsWith(SymbolTablePrefix) && table != tableName) {
+            oldTables << table;
+        }
+    }
+
+    qCDebug(log, "[%s] Materializing symbol table.", qPrintable(m_docsetName));
+
+    QElapsedTimer timer;
+    timer.start();
+
+    const auto execute = [this, &db](const QString &sql) {
+        return !isCanceled() && db.execute(sql);
+    };
+
+    // Copy the join once, so that searches do not re-evaluate it on every
+    // keystroke. Rows are copied in batches keyed by ztoken.z_pk, which an
+    // interrupted build resumes from.
+    bool ok = execute(QStringLiteral("CREATE TABLE IF NOT EXISTS %1 (name TEXT, type TEXT, path TEXT, fragment TEXT)")
+                          .arg(tableName));
+
+    const QString batchQuery
+        = symbolBatchQuery(QStringLiteral("%1 (rowid, name, type, path, fragment)").arg(tableName), QString());
+    const qint64 lastId = ok ? queryValue(db, QStringLiteral("SELECT max(z_pk) FROM ztoken")) : 0;
+    const QString copiedIdQuery = QStringLiteral("SELECT coalesce(max(rowid), 0) FROM %1").arg(tableName);
+    qint64 copiedId = ok ? queryValue(db, copiedIdQuery) : 0;
+
+    while (ok && copiedId < lastId) {
+        // Materializing takes the first half of the build.
+        m_progress.store(static_cast<int>(50 * copiedId / lastId), std::memory_order_relaxed);
+
+        ok = execute(QStringLiteral("BEGIN")) && execute(batchQuery.arg(copiedId).arg(BatchSize))
+             && execute(QStringLiteral("COMMIT"));
+
+        const qint64 id = queryValue(db, copiedIdQuery);
+        if (id == copiedId) {
+            break; // Only rows without a match in the join are left.
+        }
+
+        copiedId = id;
+    }
+
+    m_progress.store(50, std::memory_order_relaxed);
+
+    // The searchIndex view becomes a plain projection of the table, which
+    // SQLite flattens into queries, so the indexes below and the name index
+    // apply. Old tables are dropped along with it, since the old view still
+    // reads them.
+    ok = ok && execute(QStringLiteral("BEGIN"));
+    for (const QString &oldTable : std::as_const(oldTables)) {
+        ok = ok && execute(QStringLiteral("DROP TABLE '%1'").arg(oldTable));
+    }
+
+    ok = ok && execute(QStringLiteral("CREATE INDEX IF NOT EXISTS %1_type ON %1 (type, name)").arg(tableName))
+         && execute(QStringLiteral("CREATE INDEX IF NOT EXISTS %1_path ON %1 (path)").arg(tableName))
+         && execute(QStringLiteral("DROP VIEW IF EXISTS searchIndex"))
+         && execute(QStringLiteral("CREATE VIEW searchIndex AS"
+                                   "  SELECT name, type, path, fragment FROM %1")
+                        .arg(tableName))
+         && execute(QStringLiteral("COMMIT"));
+
+    if (!ok) {
+        const QString error = db.lastError();
+        db.execute(QStringLiteral("ROLLBACK"));
+
+        if (!isCanceled()) {
+            qCWarning(log, "[%s] Cannot materialize symbol table: %s", qPrintable(m_docsetName), qPrintable(error));
+        }
+
+        return false;
+    }
+
+    qCDebug(log, "[%s] Materialized symbol table in %lld ms.", qPrintable(m_docsetName), timer.elapsed());
+    return true;
+}
+
+bool NameIndex::isCanceled() const
+{
+    return m_isBuildCanceled.load(std::memory_order_relaxed);
+}
+
+// sqlite3_progress_handler() callback, a non-zero result interrupts the build.
+int NameIndex::progressCallback(void *data)
+{
+    auto *index = static_cast<NameIndex *>(data);
+
+    index->m_buildSteps += ProgressInterval;
+    if (index->m_estimatedBuildSteps > 0) {
+        // Held below 100 until the index is committed, since steps are an estimate.
+        const qint64 start = index->m_buildStartProgress;
+        const qint64 percent
+            = std::min<qint64>(99, start + ((100 - start) * index->m_buildSteps / index->m_estimatedBuildSteps));
+        index->m_progress.store(static_cast<int>(percent), std::memory_order_relaxed);
+    }
+
+    return index->isCanceled() ? 1 : 0;
+}
+
+} // namespace Zeal::Registry
@@ -0,0 +1,92 @@
+// Copyright (C) Oleg Shparber, et al. <https://zealdocs.org>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef ZEAL_REGISTRY_NAMEINDEX_H
+#define ZEAL_REGISTRY_NAMEINDEX_H
+
+#include <QFuture>
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+#include <atomic>
+#include <functional>
+
+namespace Zeal {
+
+namespace Util {
+class Database;
+} // namespace Util
+
+namespace Registry {
+
+// Case-insensitive index on docset symbol names, built in the background.
+//
+// Creating the index takes seconds on large docsets, so it is built on its own
+// connection in a low priority thread, while the docset is searched without
+// it. With an empty sidecarPath the index is created in the docset database,
+// where the symbol join of a ZDash docset is first copied into a table.
+// Otherwise, e.g. for docsets on read-only storage, the symbols are copied
+// into an indexed sidecar database in batches, which an interrupted build
+// resumes from, and the sidecar is attached to the docset connection.
+class NameIndex final
+{
+    Q_DISABLE_COPY_MOVE(NameIndex)
+public:
+    // Called on the build thread once an in-place build has written to the
+    // docset database, with the stamp the database had before, see
+    // IndexBuild::fileStamp().
+    using SourceWrittenHandler = std::function<void(const QList<qint64> &previousStamp)>;
+
+    NameIndex(const QString &docsetName,
+              const QString &sourcePath,
+              bool isZDash,
+              const QString &sidecarPath,
+              SourceWrittenHandler sourceWrittenHandler = {});
+    ~NameIndex();
+
+    bool isReady() const;
+
+    // Estimated build progress in percent, or -1 when not building.
+    int progress() const;
+
+    // Makes a ready index available to db, a docset connection without any
+    // active statements. A sidecar is attached and shadows searchIndex with a
+    // temporary view. On failure db is left as it was, and attach() can be
+    // tried again.
+    bool attach(Util::Database *db) const;
+
+private:
+    void build();
+    bool buildInPlace();
+    bool buildSidecar();
+    bool materializeSymbols(Util::Database &db);
+    bool isCanceled() const;
+
+    static int progressCallback(void *data);
+
+    QString m_docsetName;
+    QString m_sourcePath;
+    bool m_isZDash = false;
+    QString m_sidecarPath;
+    SourceWrittenHandler m_sourceWrittenHandler;
+
+    std::atomic_bool m_isReady{false};
+    std::atomic_int m_progress{-1};
+
+    // Statement steps of an in-place build, against an estimate from the row
+    // count, counted from the progress made before the index is created.
+    qint64 m_buildSteps = 0;
+    qint64 m_estimatedBuildSteps = 0;
+    int m_buildStartProgress = 0;
+
+    QFuture<void> m_buildFuture;
+    std::atomic_bool m_isBuildCanceled{false};
+    QMutex m_buildMutex;
+    Util::Database *m_buildDb = nullptr; // Guarded by m_buildMutex, for interrupting.
+};
+
+} // namespace Registry
+} // namespace Zeal
+
+#endif // ZEAL_REGISTRY_NAMEINDEX_H
@@ -7,8 +7,37 @@
 #include "docset.h"
 #include "itemdatarole.h"
 
+#include <util/fuzzy.h>
+
+#include <algorithm>
+
 namespace Zeal::Registry {
 
+namespace {
+QList<int> computeMatchPositions(const QString &query, const QString &name, bool isFuzzy)
+{
+    QList<int> positions;
+    if (query.isEmpty()) {
+        return positions;
+    }
+
+    if (isFuzzy) {
+        // Fuzzy search: use fuzzy matching algorithm.
+        Util::Fuzzy::score(query, name, &positions);
+    } else {
+        // Non-fuzzy search: highlight only first occurrence.
+        const qsizetype pos = name.indexOf(query, 0, Qt::CaseInsensitive);
+        if (pos != -1) {
+            for (int i = 0; i < query.length(); ++i) {
+                positions.append(static_cast<int>(pos + i));
+            }
+        }
+    }
+
+    return positions;
+}
+} // namespace
+
 SearchModel::SearchModel(QObject *parent)
     : QAbstractListModel(parent)
 {
@@ -18,6 +47,9 @@ SearchModel *SearchModel::clone(QObject *parent)
 {
     auto *model = new SearchModel(parent);
     model->m_dataList = m_dataList;
+    model->m_matchQuery = m_matchQuery;
+    model->m_isFuzzyMatch = m_isFuzzyMatch;
+    model->m_matchPositions = m_matchPositions;
     return model;
 }
 
@@ -39,16 +71,16 @@ QVariant SearchModel::data(const QModelIndex &index, int role) const
         return item.name;
 
     case Qt::DecorationRole:
-        return Docset::symbolTypeIcon(item.type);
+        return Docset::symbolTypeIcon(item.type());
 
     case ItemDataRole::DocsetIconRole:
-        return item.docsetIcon;
+        return item.docsetIcon();
 
     case ItemDataRole::MatchPositionsRole:
-        return QVariant::fromValue(item.matchPositions);
+        return QVariant::fromValue(matchPositions(index.row()));
 
     case ItemDataRole::UrlRole:
-        return item.url;
+        return Docset::createPageUrl(item.docsetBaseUrl(), item.path, item.fragment);
 
     default:
         return {};
@@ -77,6 +109,8 @@ bool SearchModel::removeRows(int row, int count, const QModelIndex &parent)
         return false;
     }
 
+    clearMatchPositions();
+
     beginRemoveRows(parent, row, row + count - 1);
     while (count > 0) {
         m_dataList.removeAt(row);
@@ -89,11 +123,13 @@ bool SearchModel::removeRows(int row, int count, const QModelIndex &parent)
 
 void SearchModel::removeSearchResultWithName(const QString &name)
 {
+    clearMatchPositions();
+
     QMutableListIterator<SearchResult> iterator(m_dataList);
 
     int rowNum = 0;
     while (iterator.hasNext()) {
-        if (iterator.next().docsetName == name) {
+        if (iterator.next().docsetName() == name) {
             beginRemoveRows(QModelIndex(), rowNum, rowNum);
             iterator.remove();
             rowNum -= 1;
@@ -106,9 +142,85 @@ void SearchModel::removeSearchResultWithName(const QString &name)
 void SearchModel::setResults(const QList<SearchResult> &results)
 {
     beginResetModel();
+    clearMatchPositions();
     m_dataList = results;
     endResetModel();
     emit updated();
 }
 
+void SearchModel::mergeResults(const QList<SearchResult> &results, int limit)
+{
+    clearMatchPositions();
+
+    qsizetype row = 0;
+    auto it = results.cbegin();
+    while (it != results.cend() && (limit <= 0 || row < limit)) {
+        // Skip existing rows that rank before the next new result.
+        while (row < m_dataList.size() && !(*it < m_dataList.at(row))) {
+            ++row;
+        }
+
+        // Insert the run of new results that rank before that row in one go.
+        auto last = it + 1;
+        if (row < m_dataList.size()) {
+            while (last != results.cend() && *last < m_dataList.at(row)) {
+                ++last;
+            }
+        } else {
+            last = results.cend();
+        }
+
+        qsizetype count = last - it;
+        if (limit > 0) {
+            count = std::min<qsizetype>(count, limit - row);
+        }
+
+        if (count <= 0) {
+            break;
+        }
+
+        beginInsertRows(QModelIndex(), static_cast<int>(row), static_cast<int>(row + count - 1));
+        m_dataList.insert(row, count, SearchResult());
+        std::copy(it, it + count, m_dataList.begin() + row);
+        endInsertRows();
+
+        row += count;
+        it += count;
+    }
+
+    if (limit > 0 && m_dataList.size() > limit) {
+        beginRemoveRows(QModelIndex(), limit, static_cast<int>(m_dataList.size() - 1));
+        m_dataList.resize(limit);
+        endRemoveRows();
+    }
+
+    emit updated();
+}
+
+void SearchModel::setMatchQuery(const QString &query, bool isFuzzy)
+{
+    if (query == m_matchQuery && isFuzzy == m_isFuzzyMatch) {
+        return;
+    }
+
+    m_matchQuery = query;
+    m_isFuzzyMatch = isFuzzy;
+    clearMatchPositions();
+}
+
+const QList<int> &SearchModel::matchPositions(int row) const
+{
+    auto it = m_matchPositions.constFind(row);
+    if (it == m_matchPositions.cend()) {
+        it = m_matchPositions.insert(row, computeMatchPositions(m_matchQuery, m_dataList.at(row).name, m_isFuzzyMatch));
+    }
+
+    return it.value();
+}
+
+void SearchModel::clearMatchPositions()
+{
+    m_matchPositions.clear();
+}
+
 } // namespace Zeal::Registry
@@ -8,6 +8,7 @@
 #include "searchresult.h"
 
 #include <QAbstractListModel>
+#include <QHash>
 
 namespace Zeal::Registry {
 
@@ -28,12 +29,26 @@ public:
     bool removeRows(int row, int count, const QModelIndex &parent = QModelIndex()) override;
     void removeSearchResultWithName(const QString &name);
     void setResults(const QList<SearchResult> &results = QList<SearchResult>());
+    // Inserts sorted results among the existing ones without resetting the
+    // model, then drops rows past limit (0 for no limit).
+    void mergeResults(const QList<SearchResult> &results, int limit = 0);
+
+    // Query for highlighting results. Match positions are only computed when a
+    // view asks for MatchPositionsRole, and are then kept until the rows change.
+    void setMatchQuery(const QString &query, bool isFuzzy);
 
 signals:
     void updated();
 
 private:
+    const QList<int> &matchPositions(int row) const;
+    void clearMatchPositions();
+
     QList<SearchResult> m_dataList;
+
+    QString m_matchQuery;
+    bool m_isFuzzyMatch = false;
+    mutable QHash<int, QList<int>> m_matchPositions;
 };
 
 } // namespace Zeal::Registry
@@ -0,0 +1,125 @@
+// Copyright (C) Oleg Shparber, et al. <https://zealdocs.org>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "searchresult.h"
+
+#include <QHash>
+#include <QList>
+#include <QLoggingCategory>
+#include <QReadWriteLock>
+
+#include <limits>
+
+namespace Zeal::Registry {
+
+namespace {
+Q_LOGGING_CATEGORY(log, "zeal.registry.searchresult")
+
+struct DocsetEntry
+{
+    QString name;
+    QIcon icon;
+    QUrl baseUrl;
+};
+
+// Lookups vastly outnumber insertions, which only happen for new types and
+// when docsets are loaded.
+template<typename T>
+class InternTable
+{
+public:
+    explicit InternTable(const T &empty)
+    {
+        m_values.append(empty);
+    }
+
+    T value(quint16 id) const
+    {
+        const QReadLocker locker(&m_lock);
+        return m_values.value(id, m_values.constFirst());
+    }
+
+    // Returns the id of key, appending value if the key is new. With replace,
+    // the value of an existing key is replaced as well.
+    quint16 intern(const QString &key, const T &value, bool replace)
+    {
+        if (!replace) {
+            const QReadLocker locker(&m_lock);
+            if (const auto it = m_ids.constFind(key); it != m_ids.cend()) {
+                return it.value();
+            }
+        }
+
+        const QWriteLocker locker(&m_lock);
+        if (const auto it = m_ids.constFind(key); it != m_ids.cend()) {
+            if (replace) {
+                m_values[it.value()] = value;
+            }
+            return it.value();
+        }
+
+        if (m_values.size() > std::numeric_limits<quint16>::max()) {
+            qCWarning(log, "Too many distinct values, cannot intern '%s'.", qPrintable(key));
+            return 0;
+        }
+
+        const auto id = static_cast<quint16>(m_values.size());
+        m_values.append(value);
+        m_ids.insert(key, id);
+        return id;
+    }
+
+private:
+    mutable QReadWriteLock m_lock;
+    QList<T> m_values;
+    QHash<QString, quint16> m_ids;
+};
+
+InternTable<QString> &symbolTypes()
+{
+    static InternTable<QString> table{QString()};
+    return table;
+}
+
+InternTable<DocsetEntry> &docsets()
+{
+    static InternTable<DocsetEntry> table{DocsetEntry()};
+    return table;
+}
+} // namespace
+
+QString SearchResult::type() const
+{
+    return symbolTypes().value(typeId);
+}
+
+QString SearchResult::docsetName() const
+{
+    return docsets().value(docsetId).name;
+}
+
+QIcon SearchResult::docsetIcon() const
+{
+    return docsets().value(docsetId).icon;
+}
+
+QUrl SearchResult::docsetBaseUrl() const
+{
+    return docsets().value(docsetId).baseUrl;
+}
+
+quint16 SearchResult::internSymbolType(const QString &type)
+{
+    if (type.isEmpty()) {
+        return 0;
+    }
+
+    return symbolTypes().intern(type, type, false);
+}
+
+quint16 SearchResult::internDocset(const QString &name, const QIcon &icon, const QUrl &baseUrl)
+{
+    return docsets().intern(name, {.name = name, .icon = icon, .baseUrl = baseUrl}, true);
+}
+
+} // namespace Zeal::Registry
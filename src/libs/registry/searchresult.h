@@ -6,7 +6,6 @@
 #define ZEAL_REGISTRY_SEARCHRESULT_H
 
 #include <QIcon>
-#include <QList>
 #include <QString>
 #include <QUrl>
 
@@ -17,15 +16,28 @@ namespace Zeal::Registry {
 struct SearchResult
 {
     QString name;
-    QString type;
 
-    QUrl url;
-
-    QString docsetName;
-    QIcon docsetIcon;
+    // Page location within the docset. Resolved to a URL with
+    // Docset::createPageUrl() only when the result is opened.
+    QString path;
+    QString fragment;
 
     double score = 0;
-    QList<int> matchPositions;
+
+    // Ids into the process-wide tables below; 0 is the empty type or an unknown docset.
+    quint16 typeId = 0;
+    quint16 docsetId = 0;
+
+    QString type() const;
+    QString docsetName() const;
+    QIcon docsetIcon() const;
+    QUrl docsetBaseUrl() const;
+
+    // Symbol types and docsets are interned once, so that results carry two
+    // small ids instead of their own strings, icon and URL. Ids are never
+    // reused; interning a docset name again updates its icon and base URL.
+    static quint16 internSymbolType(const QString &type);
+    static quint16 internDocset(const QString &name, const QIcon &icon, const QUrl &baseUrl);
 
     std::partial_ordering operator<=>(const SearchResult &other) const
     {
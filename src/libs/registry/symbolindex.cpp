@@ -0,0 +1,254 @@
+// Copyright (C) Oleg Shparber, et al. <https://zealdocs.org>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "symbolindex.h"
+
+#include "searchresult.h"
+
+#include <util/fuzzy.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace Zeal::Registry {
+
+namespace {
+// How many rows to scan between checks of the cancellation flag.
+constexpr int CancelCheckInterval = 1024;
+
+// Lowercases per UTF-16 code unit, so that the result has the same length as
+// the input and can share offsets with it. Matches Util::Fuzzy case folding.
+void appendLowered(QString &out, QStringView s)
+{
+    for (const QChar ch : s) {
+        out.append(ch.toLower());
+    }
+}
+} // namespace
+
+void SymbolIndex::append(QStringView name, const QString &type, QStringView path, QStringView fragment)
+{
+    m_names.append(name);
+    appendLowered(m_lowerNames, name);
+    m_nameOffsets.push_back(static_cast<quint32>(m_names.size()));
+
+    m_locations.append(path);
+    m_locationOffsets.push_back(static_cast<quint32>(m_locations.size()));
+    m_locations.append(fragment);
+    m_locationOffsets.push_back(static_cast<quint32>(m_locations.size()));
+
+    auto it = m_typeLookup.constFind(type);
+    if (it == m_typeLookup.cend()) {
+        // Docsets use a few dozen distinct types at most, but never overflow the id.
+        if (m_types.size() > std::numeric_limits<quint16>::max()) {
+            m_typeIds.push_back(0);
+            return;
+        }
+
+        it = m_typeLookup.insert(type, static_cast<quint16>(m_types.size()));
+        m_types.append(type);
+        m_internedTypeIds.push_back(SearchResult::internSymbolType(type));
+    }
+
+    m_typeIds.push_back(it.value());
+}
+
+void SymbolIndex::squeeze()
+{
+    m_names.squeeze();
+    m_lowerNames.squeeze();
+    m_nameOffsets.shrink_to_fit();
+    m_locations.squeeze();
+    m_locationOffsets.shrink_to_fit();
+    m_typeIds.shrink_to_fit();
+}
+
+int SymbolIndex::size() const
+{
+    return static_cast<int>(m_typeIds.size());
+}
+
+bool SymbolIndex::isEmpty() const
+{
+    return m_typeIds.empty();
+}
+
+QStringView SymbolIndex::name(int row) const
+{
+    return slice(m_names, m_nameOffsets, row);
+}
+
+QStringView SymbolIndex::lowerName(int row) const
+{
+    return slice(m_lowerNames, m_nameOffsets, row);
+}
+
+const QString &SymbolIndex::type(int row) const
+{
+    return m_types.at(m_typeIds.at(row));
+}
+
+quint16 SymbolIndex::typeId(int row) const
+{
+    return m_internedTypeIds.at(m_typeIds.at(row));
+}
+
+QStringView SymbolIndex::path(int row) const
+{
+    return slice(m_locations, m_locationOffsets, 2 * row);
+}
+
+QStringView SymbolIndex::fragment(int row) const
+{
+    return slice(m_locations, m_locationOffsets, (2 * row) + 1);
+}
+
+QList<SymbolIndex::Match> SymbolIndex::search(const QString &query,
+                                              bool fuzzy,
+                                              int limit,
+                                              const std::atomic_bool &canceled,
+                                              const QList<int> *candidates,
+                                              QList<int> *matchedRows) const
+{
+    QList<Match> matches;
+
+    if (query.isEmpty()) {
+        // Keyword prefix only (e.g. "html:") — list all symbols alphabetically.
+        const int count = size();
+        matches.reserve(count);
+        for (int row = 0; row < count; ++row) {
+            matches.append({.row = row, .score = 0});
+        }
+
+        const auto byName = [this](const Match &lhs, const Match &rhs) {
+            return lowerName(lhs.row) < lowerName(rhs.row);
+        };
+
+        if (limit > 0 && limit < matches.size()) {
+            std::partial_sort(matches.begin(), matches.begin() + limit, matches.end(), byName);
+            matches.resize(limit);
+        } else {
+            std::sort(matches.begin(), matches.end(), byName);
+        }
+
+        return matches;
+    }
+
+    const int count = candidates != nullptr ? static_cast<int>(candidates->size()) : size();
+    const auto rowAt = [candidates](int i) {
+        return candidates != nullptr ? candidates->at(i) : i;
+    };
+
+    // With a limit, matches is a bounded min-heap holding the best rows seen so
+    // far. Ties on score are broken by name as in SearchResult, so that the
+    // rows kept do not depend on the scan order.
+    const auto byScore = [this](const Match &lhs, const Match &rhs) {
+        if (lhs.score != rhs.score) {
+            return lhs.score > rhs.score;
+        }
+
+        return lowerName(lhs.row) < lowerName(rhs.row);
+    };
+    const auto offer = [&matches, limit, &byScore](Match match) {
+        if (limit <= 0) {
+            matches.append(match);
+        } else if (matches.size() < limit) {
+            matches.append(match);
+            std::push_heap(matches.begin(), matches.end(), byScore);
+        } else if (byScore(match, matches.constFirst())) {
+            std::pop_heap(matches.begin(), matches.end(), byScore);
+            matches.last() = match;
+            std::push_heap(matches.begin(), matches.end(), byScore);
+        }
+    };
+
+    // Whether a row scoring up to maxScore can be kept. Once the heap is
+    // full, a tie with its worst row may still win by name.
+    const auto canBeKept = [limit, &matches](double maxScore) {
+        if (limit > 0 && matches.size() >= limit) {
+            return maxScore >= matches.constFirst().score;
+        }
+
+        return maxScore > 0;
+    };
+
+    if (matchedRows != nullptr) {
+        matchedRows->clear();
+    }
+
+    if (fuzzy) {
+        QString lowerQuery;
+        appendLowered(lowerQuery, query);
+
+        for (int i = 0; i < count; ++i) {
+            if (i % CancelCheckInterval == 0 && canceled.load(std::memory_order_relaxed)) {
+                return {};
+            }
+
+            const int row = rowAt(i);
+            const QStringView lowerCandidate = lowerName(row);
+
+            // Rows that cannot reach the worst kept match, or a zero score, are
+            // not scored. They are still matched, since a longer query may
+            // score them higher.
+            const double maxScore = Util::Fuzzy::maxScore(query.size(), lowerCandidate.size());
+            const bool canScore = canBeKept(maxScore);
+            if (!canScore && (matchedRows == nullptr || maxScore == -std::numeric_limits<double>::infinity())) {
+                continue;
+            }
+
+            // Same as Util::Fuzzy::score(), but the pre-filter runs on the
+            // lowercased arena, which skips case folding for most rows.
+            if (!Util::Fuzzy::hasLoweredMatch(lowerQuery, lowerCandidate)) {
+                continue;
+            }
+
+            // Any subsequence match within the length limit has a finite score.
+            if (matchedRows != nullptr) {
+                matchedRows->append(row);
+            }
+
+            if (!canScore) {
+                continue;
+            }
+
+            const double score = Util::Fuzzy::computeScore(query, name(row));
+            if (score > 0) {
+                offer({.row = row, .score = score});
+            }
+        }
+    } else {
+        QString lowerQuery;
+        appendLowered(lowerQuery, query);
+
+        for (int i = 0; i < count; ++i) {
+            if (i % CancelCheckInterval == 0 && canceled.load(std::memory_order_relaxed)) {
+                return {};
+            }
+
+            const int row = rowAt(i);
+            const QStringView candidate = lowerName(row);
+            if (candidate.contains(lowerQuery)) {
+                if (matchedRows != nullptr) {
+                    matchedRows->append(row);
+                }
+
+                offer({.row = row, .score = -static_cast<double>(candidate.size())});
+            }
+        }
+    }
+
+    if (limit > 0) {
+        std::sort_heap(matches.begin(), matches.end(), byScore);
+    }
+
+    return matches;
+}
+
+QStringView SymbolIndex::slice(const QString &arena, const std::vector<quint32> &offsets, int row)
+{
+    const quint32 begin = offsets.at(row);
+    return QStringView(arena).sliced(begin, offsets.at(row + 1) - begin);
+}
+
+} // namespace Zeal::Registry
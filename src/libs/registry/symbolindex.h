@@ -0,0 +1,85 @@
+// Copyright (C) Oleg Shparber, et al. <https://zealdocs.org>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef ZEAL_REGISTRY_SYMBOLINDEX_H
+#define ZEAL_REGISTRY_SYMBOLINDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+
+#include <atomic>
+#include <vector>
+
+namespace Zeal::Registry {
+
+// In-memory, columnar copy of a docset's symbol table.
+//
+// All names live in a single UTF-16 arena with a lowercased twin sharing the
+// same offsets, symbol types are interned into small integer ids, and paths and
+// fragments share a second arena. A search is a linear scan over these packed
+// arrays, so no SQLite work is done per keystroke once the index is built.
+class SymbolIndex final
+{
+    Q_DISABLE_COPY_MOVE(SymbolIndex)
+public:
+    struct Match
+    {
+        int row = 0;
+        double score = 0;
+    };
+
+    SymbolIndex() = default;
+
+    void append(QStringView name, const QString &type, QStringView path, QStringView fragment);
+    void squeeze();
+
+    int size() const;
+    bool isEmpty() const;
+
+    QStringView name(int row) const;
+    QStringView lowerName(int row) const;
+    const QString &type(int row) const;
+    quint16 typeId(int row) const; // See SearchResult::internSymbolType().
+    QStringView path(int row) const;
+    QStringView fragment(int row) const;
+
+    // Mirrors the SQL queries in Docset::search(): fuzzy matches require a
+    // positive score, substring matches score -length(name), and an empty query
+    // lists symbols by name. A positive limit keeps only the best rows, which
+    // are then returned best first, with ties ordered by name like SearchResult.
+    // Fuzzy rows whose Util::Fuzzy::maxScore() cannot beat the worst row kept so
+    // far are not scored at all.
+    //
+    // If candidates is set, only those rows are scanned. If matchedRows is set,
+    // it receives every row that may still match a query extending this one,
+    // regardless of score or limit, and can be passed back as candidates.
+    QList<Match> search(const QString &query,
+                        bool fuzzy,
+                        int limit,
+                        const std::atomic_bool &canceled,
+                        const QList<int> *candidates = nullptr,
+                        QList<int> *matchedRows = nullptr) const;
+
+private:
+    static QStringView slice(const QString &arena, const std::vector<quint32> &offsets, int row);
+
+    QString m_names;
+    QString m_lowerNames;
+    std::vector<quint32> m_nameOffsets{0};
+
+    // Path and fragment of row i are the slices 2 * i and 2 * i + 1.
+    QString m_locations;
+    std::vector<quint32> m_locationOffsets{0};
+
+    std::vector<quint16> m_typeIds;
+    QStringList m_types;
+    std::vector<quint16> m_internedTypeIds;
+    QHash<QString, quint16> m_typeLookup;
+};
+
+} // namespace Zeal::Registry
+
+#endif // ZEAL_REGISTRY_SYMBOLINDEX_H
@@ -0,0 +1,268 @@
+// Copyright (C) Oleg Shparber, et al. <https://zealdocs.org>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "docsetgenerator.h"
+
+#include "../docset.h"
+#include "../searchresult.h"
+
+#include <util/database.h>
+#include <util/statement.h>
+
+#include <QScopeGuard>
+#include <QtTest>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+using namespace Zeal::Registry;
+using namespace Zeal::Util;
+
+class DocsetTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+
+    void testSearchDuringNameIndexBuild();
+    void testSearchDuringSymbolIndexBuild();
+    void testCanceledSearchReturnsNothing();
+    void testCanceledSearchDoesNotInterruptRelatedLinks();
+    void testLimitKeepsWhatSortsFirst_data();
+    void testLimitKeepsWhatSortsFirst();
+    void testUnreadableDatabaseIsReported_data();
+    void testUnreadableDatabaseIsReported();
+
+private:
+    static bool hasNameIndex(const QString &docsetPath);
+
+    std::unique_ptr<QTemporaryDir> m_dir;
+};
+
+void DocsetTest::init()
+{
+    m_dir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_dir->isValid());
+}
+
+void DocsetTest::testSearchDuringNameIndexBuild()
+{
+    // Large enough for the build to overlap a few searches.
+    const QString path
+        = Tests::generateDocset(m_dir->path(), QStringLiteral("Test"), Tests::DocsetFormat::Dash, 200000);
+    QVERIFY(!path.isEmpty());
+
+    const Docset docset(path);
+    QVERIFY(docset.isValid());
+
+    // The first search opens the database, which starts the build.
+    const std::atomic_bool canceled{false};
+    const qsizetype count = docset.search(QStringLiteral("value"), canceled).size();
+    QVERIFY(count > 0);
+
+    // Searches wait for the build to commit instead of failing.
+    QElapsedTimer timer;
+    timer.start();
+    while (!hasNameIndex(path)) {
+        QCOMPARE(docset.search(QStringLiteral("value"), canceled).size(), count);
+        QVERIFY(timer.elapsed() < 30000);
+    }
+
+    QCOMPARE(docset.search(QStringLiteral("value"), canceled).size(), count);
+}
+
+void DocsetTest::testSearchDuringSymbolIndexBuild()
+{
+    const QString path = Tests::generateDocset(m_dir->path(), QStringLiteral("Test"), Tests::DocsetFormat::Dash, 20000);
+    QVERIFY(!path.isEmpty());
+
+    Docset docset(path);
+    QVERIFY(docset.isValid());
+    docset.setSymbolIndexEnabled(true);
+
+    // Searches go through the database until the index is ready.
+    const std::atomic_bool canceled{false};
+    QVERIFY(!docset.search(QStringLiteral("value"), canceled).isEmpty());
+
+    QTRY_VERIFY(docset.isSymbolIndexReady());
+    QVERIFY(!docset.search(QStringLiteral("value"), canceled).isEmpty());
+
+    // Disabling drops the index, enabling builds it again.
+    docset.setSymbolIndexEnabled(false);
+    QVERIFY(!docset.isSymbolIndexReady());
+
+    docset.setSymbolIndexEnabled(true);
+    QVERIFY(!docset.search(QStringLiteral("value"), canceled).isEmpty());
+    QTRY_VERIFY(docset.isSymbolIndexReady());
+}
+
+void DocsetTest::testCanceledSearchReturnsNothing()
+{
+    const QString path = Tests::generateDocset(m_dir->path(), QStringLiteral("Test"), Tests::DocsetFormat::Dash, 20000);
+    QVERIFY(!path.isEmpty());
+
+    Docset docset(path);
+    QVERIFY(docset.isValid());
+
+    const std::atomic_bool canceled{true};
+    QVERIFY(docset.search(QStringLiteral("value"), canceled).isEmpty());
+
+    docset.setFuzzySearchEnabled(true);
+    QVERIFY(docset.search(QStringLiteral("gvl"), canceled).isEmpty());
+
+    docset.setSymbolIndexEnabled(true);
+    QVERIFY(docset.search(QStringLiteral("gvl"), canceled).isEmpty());
+}
+
+void DocsetTest::testCanceledSearchDoesNotInterruptRelatedLinks()
+{
+    const QString path = Tests::generateDocset(m_dir->path(), QStringLiteral("Test"), Tests::DocsetFormat::Dash, 20000);
+    QVERIFY(!path.isEmpty());
+
+    Docset docset(path);
+    QVERIFY(docset.isValid());
+    docset.setBaseUrl(QUrl(QStringLiteral("http://127.0.0.1/docsets/Test")));
+
+    // A class page, which lists its members.
+    const std::atomic_bool notCanceled{false};
+    const QList<SearchResult> members = docset.search(QStringLiteral("::"), notCanceled, {.limit = 1});
+    QCOMPARE(members.size(), 1);
+
+    const QString page = members.constFirst().path.section(QLatin1Char('#'), 0, 0);
+    const QUrl pageUrl(QStringLiteral("http://127.0.0.1/docsets/Test/") + page);
+    const qsizetype count = docset.relatedLinks(pageUrl).size();
+    QVERIFY(count > 1);
+
+    // Canceled searches abort their statements on the search connection only.
+    std::atomic_bool isDone{false};
+    std::unique_ptr<QThread> thread(QThread::create([&docset, &isDone]() {
+        const std::atomic_bool canceled{true};
+        while (!isDone.load()) {
+            docset.search(QStringLiteral("value"), canceled);
+        }
+    }));
+    thread->start();
+
+    const auto threadGuard = qScopeGuard([&thread, &isDone]() {
+        isDone.store(true);
+        thread->wait();
+    });
+
+    for (int i = 0; i < 200; ++i) {
+        QCOMPARE(docset.relatedLinks(pageUrl).size(), count);
+    }
+}
+
+void DocsetTest::testLimitKeepsWhatSortsFirst_data()
+{
+    QTest::addColumn<bool>("isZDash");
+    QTest::addColumn<bool>("isFuzzy");
+    QTest::addColumn<bool>("isSymbolIndexEnabled");
+    QTest::addColumn<QString>("query");
+
+    QTest::newRow("dash substring") << false << false << false << QStringLiteral("value");
+    QTest::newRow("dash fuzzy") << false << true << false << QStringLiteral("gvl");
+    QTest::newRow("zdash substring") << true << false << false << QStringLiteral("value");
+    QTest::newRow("zdash fuzzy") << true << true << false << QStringLiteral("gvl");
+    QTest::newRow("symbol index substring") << false << false << true << QStringLiteral("value");
+    QTest::newRow("symbol index fuzzy") << false << true << true << QStringLiteral("gvl");
+    QTest::newRow("listing") << false << false << false << QString();
+}
+
+void DocsetTest::testLimitKeepsWhatSortsFirst()
+{
+    QFETCH(bool, isZDash);
+    QFETCH(bool, isFuzzy);
+    QFETCH(bool, isSymbolIndexEnabled);
+    QFETCH(QString, query);
+
+    const QString path = Tests::generateDocset(m_dir->path(),
+                                               QStringLiteral("Test"),
+                                               isZDash ? Tests::DocsetFormat::ZDash : Tests::DocsetFormat::Dash,
+                                               20000);
+    QVERIFY(!path.isEmpty());
+
+    Docset docset(path);
+    QVERIFY(docset.isValid());
+    docset.setFuzzySearchEnabled(isFuzzy);
+    docset.setSymbolIndexEnabled(isSymbolIndexEnabled);
+
+    // Many generated names have the same length, and so the same score.
+    const std::atomic_bool canceled{false};
+    if (isSymbolIndexEnabled) {
+        // The first search starts the build.
+        docset.search(query, canceled);
+        QTRY_VERIFY(docset.isSymbolIndexReady());
+    }
+
+    QList<SearchResult> all = docset.search(query, canceled);
+    QVERIFY(all.size() > 100);
+    std::ranges::sort(all);
+
+    const auto lowerNames = [](const QList<SearchResult> &results) {
+        QStringList names;
+        for (const SearchResult &result : results) {
+            names.append(result.name.toLower());
+        }
+        return names;
+    };
+
+    const QList<SearchResult> limited = docset.search(query, canceled, {.limit = 100});
+    QCOMPARE(lowerNames(limited), lowerNames(all.first(100)));
+}
+
+void DocsetTest::testUnreadableDatabaseIsReported_data()
+{
+    QTest::addColumn<QByteArray>("data");
+
+    QTest::newRow("empty") << QByteArray();
+    QTest::newRow("corrupt") << QByteArray("not an SQLite database").repeated(100);
+}
+
+void DocsetTest::testUnreadableDatabaseIsReported()
+{
+    QFETCH(QByteArray, data);
+
+    const QString path = Tests::generateDocset(m_dir->path(), QStringLiteral("Test"), Tests::DocsetFormat::Dash, 10);
+    QVERIFY(!path.isEmpty());
+
+    QFile file(path + QLatin1String("/Contents/Resources/docSet.dsidx"));
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    QCOMPARE(file.write(data), data.size());
+    file.close();
+
+    // Loading does not open the database.
+    Docset docset(path);
+    QVERIFY(docset.isValid());
+
+    int errorCount = 0;
+    docset.setDatabaseErrorHandler([&errorCount]() {
+        ++errorCount;
+    });
+
+    const std::atomic_bool canceled{false};
+    QVERIFY(docset.search(QStringLiteral("value"), canceled).isEmpty());
+    QVERIFY(docset.search(QStringLiteral("value"), canceled).isEmpty());
+    QCOMPARE(errorCount, 1);
+    QVERIFY(!docset.isValid());
+}
+
+bool DocsetTest::hasNameIndex(const QString &docsetPath)
+{
+    Database db(docsetPath + QLatin1String("/Contents/Resources/docSet.dsidx"),
+                {.mode = Database::OpenMode::ReadOnly, .busyTimeout = 10000});
+    Statement stmt(db, QStringLiteral("PRAGMA INDEX_LIST('searchIndex')"));
+    while (stmt.step()) {
+        if (stmt.value(1).toString().startsWith(QLatin1String("__zi_name"))) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+QTEST_MAIN(DocsetTest)
+
+#include "docset_test.moc"
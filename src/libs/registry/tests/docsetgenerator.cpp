@@ -0,0 +1,349 @@
+// Copyright (C) Oleg Shparber, et al. <https://zealdocs.org>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "docsetgenerator.h"
+
+#include <util/database.h>
+#include <util/statement.h>
+
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QRandomGenerator>
+#include <QVariant>
+
+#include <algorithm>
+#include <cmath>
+
+namespace Zeal::Registry::Tests {
+
+namespace {
+// Rows per INSERT. Statements are not reused, so batching keeps the number of
+// prepared statements low. At four columns this stays under the 999 variable
+// limit of older SQLite versions.
+constexpr int InsertBatchSize = 200;
+
+const QStringList &vocabulary()
+{
+    // Roughly ordered by how often the words appear in API names.
+    static const QStringList words = {
+        QStringLiteral("get"),     QStringLiteral("set"),     QStringLiteral("value"),   QStringLiteral("string"),
+        QStringLiteral("list"),    QStringLiteral("item"),    QStringLiteral("data"),    QStringLiteral("type"),
+        QStringLiteral("name"),    QStringLiteral("size"),    QStringLiteral("index"),   QStringLiteral("file"),
+        QStringLiteral("view"),    QStringLiteral("model"),   QStringLiteral("map"),     QStringLiteral("key"),
+        QStringLiteral("node"),    QStringLiteral("event"),   QStringLiteral("text"),    QStringLiteral("count"),
+        QStringLiteral("add"),     QStringLiteral("remove"),  QStringLiteral("insert"),  QStringLiteral("append"),
+        QStringLiteral("read"),    QStringLiteral("write"),   QStringLiteral("open"),    QStringLiteral("close"),
+        QStringLiteral("buffer"),  QStringLiteral("stream"),  QStringLiteral("path"),    QStringLiteral("url"),
+        QStringLiteral("request"), QStringLiteral("response"), QStringLiteral("handler"), QStringLiteral("error"),
+        QStringLiteral("widget"),  QStringLiteral("window"),  QStringLiteral("layout"),  QStringLiteral("style"),
+        QStringLiteral("color"),   QStringLiteral("image"),   QStringLiteral("font"),    QStringLiteral("line"),
+        QStringLiteral("point"),   QStringLiteral("rect"),    QStringLiteral("time"),    QStringLiteral("date"),
+        QStringLiteral("thread"),  QStringLiteral("mutex"),   QStringLiteral("lock"),    QStringLiteral("queue"),
+        QStringLiteral("task"),    QStringLiteral("process"), QStringLiteral("parse"),   QStringLiteral("format"),
+        QStringLiteral("convert"), QStringLiteral("clear"),   QStringLiteral("find"),    QStringLiteral("sort"),
+        QStringLiteral("filter"),  QStringLiteral("tree"),    QStringLiteral("table"),   QStringLiteral("query"),
+        QStringLiteral("result"),  QStringLiteral("socket"),  QStringLiteral("hash"),    QStringLiteral("vector"),
+    };
+    return words;
+}
+
+struct SymbolType
+{
+    QString name;
+    int weight = 0; // Percent of symbols.
+};
+
+const QList<SymbolType> &symbolTypes()
+{
+    static const QList<SymbolType> types = {
+        {.name = QStringLiteral("Method"), .weight = 48},
+        {.name = QStringLiteral("Function"), .weight = 15},
+        {.name = QStringLiteral("Class"), .weight = 10},
+        {.name = QStringLiteral("Property"), .weight = 10},
+        {.name = QStringLiteral("Constant"), .weight = 8},
+        {.name = QStringLiteral("Enum"), .weight = 6},
+        {.name = QStringLiteral("Guide"), .weight = 3},
+    };
+    return types;
+}
+
+class NameGenerator
+{
+public:
+    explicit NameGenerator(quint32 seed, int symbolCount)
+        : m_random(seed)
+    {
+        const int classCount = std::max(50, symbolCount / 40);
+        m_classes.reserve(classCount);
+        for (int i = 0; i < classCount; ++i) {
+            QString name = capitalized(word()) + capitalized(word());
+            if (m_random.bounded(3) == 0) {
+                name.prepend(QStringLiteral("Abstract"));
+            }
+
+            // Keep class names unique, like pages in a real docset.
+            m_classes.append(name + QString::number(i));
+        }
+    }
+
+    // Returns an index into types().
+    int type()
+    {
+        int roll = m_random.bounded(100);
+        const QList<SymbolType> &types = symbolTypes();
+        for (int i = 0; i < types.size(); ++i) {
+            roll -= types.at(i).weight;
+            if (roll < 0) {
+                return i;
+            }
+        }
+
+        return 0;
+    }
+
+    int classIndex()
+    {
+        return skewed(static_cast<int>(m_classes.size()));
+    }
+
+    const QString &className(int index) const
+    {
+        return m_classes.at(index);
+    }
+
+    QString symbolName(const QString &typeName, const QString &className)
+    {
+        if (typeName == QLatin1String("Class")) {
+            return className;
+        }
+
+        if (typeName == QLatin1String("Function")) {
+            return word() + QLatin1Char('_') + word();
+        }
+
+        if (typeName == QLatin1String("Constant") || typeName == QLatin1String("Enum")) {
+            return className + QLatin1Char('.') + word().toUpper() + QLatin1Char('_') + word().toUpper();
+        }
+
+        if (typeName == QLatin1String("Guide")) {
+            return capitalized(word()) + QLatin1Char(' ') + word() + QLatin1Char(' ') + word();
+        }
+
+        QString member = word();
+        const int extraWords = m_random.bounded(3);
+        for (int i = 0; i < extraWords; ++i) {
+            member += capitalized(word());
+        }
+
+        return className + (typeName == QLatin1String("Property") ? QStringLiteral(".") : QStringLiteral("::"))
+               + member;
+    }
+
+private:
+    // Zipf-like: low indexes are picked much more often.
+    int skewed(int size)
+    {
+        const double r = m_random.generateDouble();
+        return std::min(size - 1, static_cast<int>(std::floor(size * r * r * r)));
+    }
+
+    const QString &word()
+    {
+        return vocabulary().at(skewed(static_cast<int>(vocabulary().size())));
+    }
+
+    static QString capitalized(const QString &word)
+    {
+        return word.left(1).toUpper() + word.mid(1);
+    }
+
+    QRandomGenerator m_random;
+    QStringList m_classes;
+};
+
+// Collects rows and inserts them InsertBatchSize at a time.
+class BatchInserter
+{
+public:
+    BatchInserter(Util::Database &db, const QString &table, int columnCount)
+        : m_db(db)
+        , m_table(table)
+        , m_columnCount(columnCount)
+    {
+    }
+
+    bool append(const QVariantList &row)
+    {
+        m_rows.append(row);
+        return m_rows.size() < InsertBatchSize || flush();
+    }
+
+    bool flush()
+    {
+        if (m_rows.isEmpty()) {
+            return true;
+        }
+
+        const QString placeholders = QLatin1Char('(') + QStringList(m_columnCount, QStringLiteral("?")).join(u',')
+                                     + QLatin1Char(')');
+        const QString sql = QStringLiteral("INSERT INTO %1 VALUES %2")
+                                .arg(m_table, QStringList(m_rows.size(), placeholders).join(u','));
+
+        Util::Statement stmt(m_db, sql);
+        int index = 1;
+        for (const QVariantList &row : std::as_const(m_rows)) {
+            for (const QVariant &value : row) {
+                if (value.typeId() == QMetaType::Int) {
+                    stmt.bindInt(index++, value.toInt());
+                } else {
+                    stmt.bindText(index++, value.toString());
+                }
+            }
+        }
+
+        m_rows.clear();
+        stmt.step();
+        return stmt.lastError().isEmpty();
+    }
+
+private:
+    Util::Database &m_db;
+    QString m_table;
+    int m_columnCount = 0;
+    QList<QVariantList> m_rows;
+};
+
+bool writeInfoPlist(const QString &path, const QString &name)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    const QString keyword = name.toLower();
+    file.write(QStringLiteral("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                              "<plist version=\"1.0\">\n"
+                              "<dict>\n"
+                              "  <key>CFBundleName</key><string>%1</string>\n"
+                              "  <key>DocSetPlatformFamily</key><string>%2</string>\n"
+                              "  <key>dashIndexFilePath</key><string>index.html</string>\n"
+                              "  <key>isDashDocset</key><true/>\n"
+                              "</dict>\n"
+                              "</plist>\n")
+                   .arg(name, keyword)
+                   .toUtf8());
+    return true;
+}
+
+bool writeDash(Util::Database &db, NameGenerator &generator, int symbolCount)
+{
+    if (!db.execute(QStringLiteral("CREATE TABLE searchIndex(id INTEGER PRIMARY KEY, name TEXT, type TEXT, path TEXT)"))) {
+        return false;
+    }
+
+    BatchInserter symbols(db, QStringLiteral("searchIndex (name, type, path)"), 3);
+    for (int i = 0; i < symbolCount; ++i) {
+        const QString &typeName = symbolTypes().at(generator.type()).name;
+        const QString &className = generator.className(generator.classIndex());
+        const QString name = generator.symbolName(typeName, className);
+        const QString path = className.toLower() + QLatin1String(".html#") + name;
+
+        if (!symbols.append({name, typeName, path})) {
+            return false;
+        }
+    }
+
+    return symbols.flush();
+}
+
+bool writeZDash(Util::Database &db, NameGenerator &generator, int symbolCount)
+{
+    const bool ok = db.execute(QStringLiteral("CREATE TABLE ztokentype (z_pk INTEGER PRIMARY KEY, ztypename TEXT)"))
+                    && db.execute(QStringLiteral("CREATE TABLE zfilepath (z_pk INTEGER PRIMARY KEY, zpath TEXT)"))
+                    && db.execute(QStringLiteral("CREATE TABLE ztokenmetainformation"
+                                                 " (z_pk INTEGER PRIMARY KEY, zfile INTEGER, zanchor TEXT)"))
+                    && db.execute(QStringLiteral("CREATE TABLE ztoken (z_pk INTEGER PRIMARY KEY, ztokenname TEXT,"
+                                                 " ztokentype INTEGER, zmetainformation INTEGER)"));
+    if (!ok) {
+        return false;
+    }
+
+    BatchInserter types(db, QStringLiteral("ztokentype"), 2);
+    const QList<SymbolType> &typeList = symbolTypes();
+    for (int i = 0; i < typeList.size(); ++i) {
+        types.append({i + 1, typeList.at(i).name});
+    }
+
+    BatchInserter files(db, QStringLiteral("zfilepath"), 2);
+    QHash<int, int> fileIds; // Class index to zfilepath.z_pk.
+
+    BatchInserter metainformation(db, QStringLiteral("ztokenmetainformation"), 3);
+    BatchInserter tokens(db, QStringLiteral("ztoken"), 4);
+
+    for (int i = 0; i < symbolCount; ++i) {
+        const int type = generator.type();
+        const int classIndex = generator.classIndex();
+        const QString &className = generator.className(classIndex);
+        const QString name = generator.symbolName(typeList.at(type).name, className);
+
+        int fileId = fileIds.value(classIndex);
+        if (fileId == 0) {
+            fileId = static_cast<int>(fileIds.size()) + 1;
+            fileIds.insert(classIndex, fileId);
+            if (!files.append({fileId, className.toLower() + QLatin1String(".html")})) {
+                return false;
+            }
+        }
+
+        const int id = i + 1;
+        if (!metainformation.append({id, fileId, name}) || !tokens.append({id, name, type + 1, id})) {
+            return false;
+        }
+    }
+
+    return types.flush() && files.flush() && metainformation.flush() && tokens.flush();
+}
+} // namespace
+
+QString generateDocset(const QString &dir, const QString &name, DocsetFormat format, int symbolCount, quint32 seed)
+{
+    const QString docsetPath = QDir(dir).filePath(name + QLatin1String(".docset"));
+    const QDir docsetDir(docsetPath);
+
+    if (!docsetDir.mkpath(QStringLiteral("Contents/Resources/Documents"))) {
+        return {};
+    }
+
+    if (!writeInfoPlist(docsetDir.filePath(QStringLiteral("Contents/Info.plist")), name)) {
+        return {};
+    }
+
+    QFile index(docsetDir.filePath(QStringLiteral("Contents/Resources/Documents/index.html")));
+    if (!index.open(QIODevice::WriteOnly)) {
+        return {};
+    }
+    index.write("<html><body>Generated docset</body></html>\n");
+    index.close();
+
+    const QString dbPath = docsetDir.filePath(QStringLiteral("Contents/Resources/docSet.dsidx"));
+    QFile::remove(dbPath);
+
+    Util::Database db(dbPath);
+    if (!db.isOpen() || !db.execute(QStringLiteral("BEGIN"))) {
+        return {};
+    }
+
+    NameGenerator generator(seed, symbolCount);
+    const bool ok = format == DocsetFormat::Dash ? writeDash(db, generator, symbolCount)
+                                                 : writeZDash(db, generator, symbolCount);
+
+    if (!ok || !db.execute(QStringLiteral("COMMIT"))) {
+        return {};
+    }
+
+    return docsetPath;
+}
+
+} // namespace Zeal::Registry::Tests
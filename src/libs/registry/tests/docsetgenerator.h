@@ -0,0 +1,26 @@
+// Copyright (C) Oleg Shparber, et al. <https://zealdocs.org>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef ZEAL_REGISTRY_TESTS_DOCSETGENERATOR_H
+#define ZEAL_REGISTRY_TESTS_DOCSETGENERATOR_H
+
+#include <QString>
+
+namespace Zeal::Registry::Tests {
+
+enum class DocsetFormat {
+    Dash, // Flat searchIndex table.
+    ZDash // Core Data tables joined by the searchIndex view.
+};
+
+// Writes a synthetic docset with symbolCount symbols to <dir>/<name>.docset,
+// using name in lowercase as its keyword. Names are built from a small
+// identifier vocabulary with a skewed word distribution, so that common
+// prefixes match many symbols like in real docsets. The same seed always
+// produces the same docset. Returns the docset path, or an empty string on
+// failure.
+QString generateDocset(const QString &dir, const QString &name, DocsetFormat format, int symbolCount, quint32 seed = 1);
+
+} // namespace Zeal::Registry::Tests
+
+#endif // ZEAL_REGISTRY_TESTS_DOCSETGENERATOR_H
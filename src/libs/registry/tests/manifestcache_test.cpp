@@ -0,0 +1,192 @@
+// Copyright (C) Oleg Shparber, et al. <https://zealdocs.org>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "../docset.h"
+#include "../indexbuild.h"
+#include "../manifestcache.h"
+
+#include <QtTest>
+
+#include <memory>
+
+using namespace Zeal::Registry;
+
+class ManifestCacheTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+
+    void testRoundTrip();
+    void testChangedFileInvalidatesEntry();
+    void testChangeAfterReadingInvalidatesEntry();
+    void testEntryWithoutStampIsNotInserted();
+    void testOwnDatabaseWriteKeepsEntry();
+    void testMissingEntry();
+    void testOtherFormatIsIgnored();
+    void testDocsetFromEntrySkipsPlist();
+
+private:
+    static void writeFile(const QString &path, const QByteArray &data);
+    Docset::ManifestEntry sampleEntry() const;
+
+    std::unique_ptr<QTemporaryDir> m_dir;
+    QString m_docsetPath;
+    QString m_cachePath;
+};
+
+void ManifestCacheTest::init()
+{
+    m_dir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_dir->isValid());
+
+    m_docsetPath = m_dir->filePath(QStringLiteral("Qt.docset"));
+    m_cachePath = m_dir->filePath(QStringLiteral("cache/docsets.manifest"));
+
+    writeFile(m_docsetPath + QLatin1String("/meta.json"), R"({"name": "Qt_6", "title": "Qt 6"})");
+    writeFile(m_docsetPath + QLatin1String("/Contents/Resources/docSet.dsidx"), QByteArray());
+    QVERIFY(QDir().mkpath(m_docsetPath + QLatin1String("/Contents/Resources/Documents")));
+}
+
+void ManifestCacheTest::testRoundTrip()
+{
+    ManifestCache cache(m_cachePath);
+    cache.insert(m_docsetPath, sampleEntry());
+    QVERIFY(cache.save());
+
+    ManifestCache loaded(m_cachePath);
+    QVERIFY(loaded.load());
+
+    const auto entry = loaded.entry(m_docsetPath);
+    QVERIFY(entry.has_value());
+    QCOMPARE(entry->name, QStringLiteral("Qt_6"));
+    QCOMPARE(entry->title, QStringLiteral("Qt 6"));
+    QCOMPARE(entry->keywords, QStringList({QStringLiteral("qt"), QStringLiteral("qt6")}));
+    QCOMPARE(entry->revision, 3);
+    QCOMPARE(entry->indexFilePath, QStringLiteral("index.html"));
+    QVERIFY(entry->isJavaScriptEnabled);
+    QVERIFY(entry->hasSymbolCounts);
+    QCOMPARE(entry->symbolStrings.values(QStringLiteral("Class")), QStringList({QStringLiteral("cl")}));
+    QCOMPARE(entry->symbolCounts.value(QStringLiteral("Class")), 42);
+    QCOMPARE(entry->fileStamp, ManifestCache::fileStamp(m_docsetPath));
+}
+
+void ManifestCacheTest::testChangedFileInvalidatesEntry()
+{
+    ManifestCache cache(m_cachePath);
+    cache.insert(m_docsetPath, sampleEntry());
+    QVERIFY(cache.entry(m_docsetPath).has_value());
+
+    // A reinstalled docset gets a new Info.plist.
+    writeFile(m_docsetPath + QLatin1String("/Contents/Info.plist"), "<plist/>");
+    QVERIFY(!cache.entry(m_docsetPath).has_value());
+}
+
+void ManifestCacheTest::testChangeAfterReadingInvalidatesEntry()
+{
+    writeFile(m_docsetPath + QLatin1String("/Contents/Info.plist"),
+              R"(<?xml version="1.0" encoding="UTF-8"?><plist version="1.0"><dict/></plist>)");
+
+    const Docset docset(m_docsetPath);
+    QVERIFY(docset.isValid());
+
+    ManifestCache cache(m_cachePath);
+    cache.insert(m_docsetPath, docset.manifestEntry());
+    QVERIFY(cache.entry(m_docsetPath).has_value());
+
+    // Updated after the docset was read, but before the cache was saved.
+    writeFile(m_docsetPath + QLatin1String("/meta.json"), R"({"name": "Qt_6", "title": "Qt 6", "revision": "4"})");
+    cache.insert(m_docsetPath, docset.manifestEntry());
+    QVERIFY(!cache.entry(m_docsetPath).has_value());
+}
+
+void ManifestCacheTest::testEntryWithoutStampIsNotInserted()
+{
+    Docset::ManifestEntry entry = sampleEntry();
+    entry.fileStamp.clear();
+
+    ManifestCache cache(m_cachePath);
+    cache.insert(m_docsetPath, entry);
+    QVERIFY(!cache.entry(m_docsetPath).has_value());
+}
+
+void ManifestCacheTest::testOwnDatabaseWriteKeepsEntry()
+{
+    const QString databasePath = m_docsetPath + QLatin1String("/Contents/Resources/docSet.dsidx");
+    Docset::ManifestEntry entry = sampleEntry();
+    const QList<qint64> previousStamp = IndexBuild::fileStamp(databasePath);
+
+    // Like a name index build adding its index to the database.
+    writeFile(databasePath, "index");
+    QVERIFY(ManifestCache::restampDatabase(&entry.fileStamp, m_docsetPath, previousStamp));
+
+    ManifestCache cache(m_cachePath);
+    cache.insert(m_docsetPath, entry);
+    QVERIFY(cache.entry(m_docsetPath).has_value());
+
+    // A database changed by something else before is still noticed.
+    const QList<qint64> stamp = entry.fileStamp;
+    QVERIFY(!ManifestCache::restampDatabase(&entry.fileStamp, m_docsetPath, previousStamp));
+    QCOMPARE(entry.fileStamp, stamp);
+}
+
+void ManifestCacheTest::testMissingEntry()
+{
+    ManifestCache cache(m_cachePath);
+    QVERIFY(!cache.load());
+    QVERIFY(!cache.entry(m_docsetPath).has_value());
+}
+
+void ManifestCacheTest::testOtherFormatIsIgnored()
+{
+    writeFile(m_cachePath, "not a manifest cache");
+
+    ManifestCache cache(m_cachePath);
+    QVERIFY(!cache.load());
+    QVERIFY(!cache.entry(m_docsetPath).has_value());
+}
+
+void ManifestCacheTest::testDocsetFromEntrySkipsPlist()
+{
+    // Without Info.plist the docset cannot be loaded from its files.
+    QVERIFY(!Docset(m_docsetPath).isValid());
+
+    const Docset docset(m_docsetPath, sampleEntry());
+    QVERIFY(docset.isValid());
+    QCOMPARE(docset.name(), QStringLiteral("Qt_6"));
+    QCOMPARE(docset.keywords(), QStringList({QStringLiteral("qt"), QStringLiteral("qt6")}));
+    QCOMPARE(docset.symbolCount(QStringLiteral("Class")), 42);
+
+    const Docset::ManifestEntry entry = docset.manifestEntry();
+    QCOMPARE(entry.title, QStringLiteral("Qt 6"));
+    QCOMPARE(entry.symbolCounts, sampleEntry().symbolCounts);
+}
+
+void ManifestCacheTest::writeFile(const QString &path, const QByteArray &data)
+{
+    QVERIFY(QDir().mkpath(QFileInfo(path).absolutePath()));
+
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    QCOMPARE(file.write(data), data.size());
+}
+
+Docset::ManifestEntry ManifestCacheTest::sampleEntry() const
+{
+    Docset::ManifestEntry entry{.name = QStringLiteral("Qt_6"),
+                                .title = QStringLiteral("Qt 6"),
+                                .keywords = {QStringLiteral("qt"), QStringLiteral("qt6")},
+                                .version = QStringLiteral("6.8"),
+                                .revision = 3,
+                                .indexFilePath = QStringLiteral("index.html"),
+                                .isJavaScriptEnabled = true,
+                                .hasSymbolCounts = true,
+                                .fileStamp = ManifestCache::fileStamp(m_docsetPath)};
+    entry.symbolStrings.insert(QStringLiteral("Class"), QStringLiteral("cl"));
+    entry.symbolCounts.insert(QStringLiteral("Class"), 42);
+    return entry;
+}
+
+QTEST_MAIN(ManifestCacheTest)
+#include "manifestcache_test.moc"
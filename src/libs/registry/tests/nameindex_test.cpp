@@ -0,0 +1,271 @@
+// Copyright (C) Oleg Shparber, et al. <https://zealdocs.org>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "../indexbuild.h"
+#include "../nameindex.h"
+
+#include <util/database.h>
+#include <util/statement.h>
+
+#include <QtTest>
+
+#include <memory>
+
+using namespace Zeal::Registry;
+using namespace Zeal::Util;
+
+class NameIndexTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+
+    void testInPlaceBuild();
+    void testOldIndexIsReplaced();
+    void testInPlaceBuildReportsWrite();
+    void testSidecarShadowsSearchIndex();
+    void testSidecarBuildResumes();
+    void testFailedAttachCanBeRetried();
+    void testZDashSymbolsAreMaterialized();
+    void testZDashNameIndexIsUsed();
+
+private:
+    std::unique_ptr<NameIndex> createIndex(const QString &sidecarPath = QString()) const;
+    static void createZDash(const QString &path);
+    static QStringList indexNames(Database &db, const QString &table = QStringLiteral("searchIndex"));
+    static QStringList names(Database &db);
+
+    std::unique_ptr<QTemporaryDir> m_dir;
+    QString m_sourcePath;
+    QString m_sidecarPath;
+};
+
+void NameIndexTest::init()
+{
+    m_dir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_dir->isValid());
+
+    m_sourcePath = m_dir->filePath(QStringLiteral("docSet.dsidx"));
+    m_sidecarPath = m_dir->filePath(QStringLiteral("cache/docset.sqlite"));
+
+    Database db(m_sourcePath);
+    QVERIFY(db.execute(QStringLiteral("CREATE TABLE searchIndex (id INTEGER PRIMARY KEY, name TEXT, type TEXT, path TEXT)")));
+    QVERIFY(db.execute(QStringLiteral("INSERT INTO searchIndex (name, type, path) VALUES"
+                                      "  ('QString', 'Class', 'qstring.html'),"
+                                      "  ('QString::arg', 'Method', 'qstring.html#arg'),"
+                                      "  ('QStringList', 'Class', 'qstringlist.html'),"
+                                      "  ('qHash', 'Function', 'qhash.html')")));
+}
+
+void NameIndexTest::testInPlaceBuild()
+{
+    const auto index = createIndex();
+    QTRY_VERIFY(index->isReady());
+    QCOMPARE(index->progress(), -1);
+
+    Database db(m_sourcePath);
+    QVERIFY(index->attach(&db));
+    QCOMPARE(indexNames(db), QStringList({QStringLiteral("__zi_name0001")}));
+}
+
+void NameIndexTest::testOldIndexIsReplaced()
+{
+    {
+        Database db(m_sourcePath);
+        QVERIFY(db.execute(QStringLiteral("CREATE INDEX __zi_name0000 ON searchIndex (name)")));
+    }
+
+    const auto index = createIndex();
+    QTRY_VERIFY(index->isReady());
+
+    Database db(m_sourcePath);
+    QCOMPARE(indexNames(db), QStringList({QStringLiteral("__zi_name0001")}));
+}
+
+void NameIndexTest::testInPlaceBuildReportsWrite()
+{
+    const QList<qint64> sourceStamp = IndexBuild::fileStamp(m_sourcePath);
+
+    int writeCount = 0;
+    QList<qint64> reportedStamp;
+    const auto sourceWritten = [&writeCount, &reportedStamp](const QList<qint64> &previousStamp) {
+        ++writeCount;
+        reportedStamp = previousStamp;
+    };
+
+    {
+        const NameIndex index(QStringLiteral("Test"), m_sourcePath, false, QString(), sourceWritten);
+        QTRY_VERIFY(index.isReady());
+    }
+
+    QCOMPARE(writeCount, 1);
+    QCOMPARE(reportedStamp, sourceStamp);
+
+    // An existing index is left as it is.
+    {
+        const NameIndex index(QStringLiteral("Test"), m_sourcePath, false, QString(), sourceWritten);
+        QTRY_VERIFY(index.isReady());
+    }
+
+    QCOMPARE(writeCount, 1);
+}
+
+void NameIndexTest::testSidecarShadowsSearchIndex()
+{
+    const auto index = createIndex(m_sidecarPath);
+    QTRY_VERIFY(index->isReady());
+
+    // The docset database is left as it is.
+    Database db(m_sourcePath);
+    QVERIFY(indexNames(db).isEmpty());
+
+    QVERIFY(index->attach(&db));
+    QCOMPARE(names(db),
+             QStringList({QStringLiteral("qHash"),
+                          QStringLiteral("QString"),
+                          QStringLiteral("QString::arg"),
+                          QStringLiteral("QStringList")}));
+}
+
+void NameIndexTest::testSidecarBuildResumes()
+{
+    {
+        const auto index = createIndex(m_sidecarPath);
+        QTRY_VERIFY(index->isReady());
+    }
+
+    // Leave the sidecar as if the build had been interrupted after two rows.
+    {
+        Database sidecar(m_sidecarPath);
+        QVERIFY(sidecar.execute(QStringLiteral("DELETE FROM symbols WHERE id > 2")));
+        QVERIFY(sidecar.execute(QStringLiteral("DELETE FROM meta WHERE key = 'complete'")));
+    }
+
+    const auto index = createIndex(m_sidecarPath);
+    QTRY_VERIFY(index->isReady());
+
+    Database db(m_sourcePath);
+    QVERIFY(index->attach(&db));
+    QCOMPARE(names(db).size(), 4);
+}
+
+void NameIndexTest::testFailedAttachCanBeRetried()
+{
+    const auto index = createIndex(m_sidecarPath);
+    QTRY_VERIFY(index->isReady());
+
+    // Taken, e.g. by an earlier attach, so attaching the sidecar fails.
+    Database db(m_sourcePath);
+    QVERIFY(db.execute(QStringLiteral("ATTACH DATABASE ':memory:' AS nameindex")));
+    QVERIFY(!index->attach(&db));
+    QCOMPARE(names(db).size(), 4);
+    QVERIFY(db.views().isEmpty());
+
+    QVERIFY(db.execute(QStringLiteral("DETACH DATABASE nameindex")));
+    QVERIFY(index->attach(&db));
+    QCOMPARE(db.views(), QStringList({QStringLiteral("searchIndex")}));
+    QCOMPARE(names(db).size(), 4);
+}
+
+void NameIndexTest::testZDashSymbolsAreMaterialized()
+{
+    const QString path = m_dir->filePath(QStringLiteral("zdash.dsidx"));
+    createZDash(path);
+
+    // Searched through a join until the build is done, like Docset does.
+    Database db(path, {.mode = Database::OpenMode::ReadOnly});
+    QVERIFY(db.execute(QStringLiteral("CREATE TEMP VIEW searchIndex AS SELECT ztokenname AS name FROM ztoken")));
+
+    const NameIndex index(QStringLiteral("Test"), path, true, QString());
+    QTRY_VERIFY(index.isReady());
+    QVERIFY(index.attach(&db));
+
+    QVERIFY(db.tables().contains(QStringLiteral("__zi_symbols0001")));
+    QCOMPARE(db.views(), QStringList({QStringLiteral("searchIndex")}));
+
+    Statement stmt(db,
+                   QStringLiteral("SELECT name, type, path, fragment FROM searchIndex WHERE name = 'QString::arg'"));
+    QVERIFY(stmt.step());
+    QCOMPARE(stmt.value(1).toString(), QStringLiteral("Method"));
+    QCOMPARE(stmt.value(2).toString(), QStringLiteral("qstring.html"));
+    QCOMPARE(stmt.value(3).toString(), QStringLiteral("arg"));
+
+    QCOMPARE(names(db).size(), 3);
+}
+
+void NameIndexTest::testZDashNameIndexIsUsed()
+{
+    const QString path = m_dir->filePath(QStringLiteral("zdash.dsidx"));
+    createZDash(path);
+
+    // Left behind by earlier versions, which indexed ztoken.
+    {
+        Database db(path);
+        QVERIFY(db.execute(QStringLiteral("CREATE INDEX __zi_name0001 ON ztoken (ztokenname COLLATE NOCASE)")));
+    }
+
+    const NameIndex index(QStringLiteral("Test"), path, true, QString());
+    QTRY_VERIFY(index.isReady());
+
+    Database db(path);
+    QVERIFY(indexNames(db, QStringLiteral("ztoken")).isEmpty());
+    QVERIFY(indexNames(db, QStringLiteral("__zi_symbols0001")).contains(QStringLiteral("__zi_name0001")));
+
+    Statement stmt(db,
+                   QStringLiteral("EXPLAIN QUERY PLAN"
+                                  "  SELECT name FROM searchIndex WHERE name = 'qhash' COLLATE NOCASE"));
+    QVERIFY(stmt.step());
+    QVERIFY(stmt.value(3).toString().contains(QLatin1String("__zi_name0001")));
+}
+
+std::unique_ptr<NameIndex> NameIndexTest::createIndex(const QString &sidecarPath) const
+{
+    return std::make_unique<NameIndex>(QStringLiteral("Test"), m_sourcePath, false, sidecarPath);
+}
+
+void NameIndexTest::createZDash(const QString &path)
+{
+    Database db(path);
+    QVERIFY(db.execute(QStringLiteral("CREATE TABLE ztokentype (z_pk INTEGER PRIMARY KEY, ztypename TEXT)")));
+    QVERIFY(db.execute(QStringLiteral("CREATE TABLE zfilepath (z_pk INTEGER PRIMARY KEY, zpath TEXT)")));
+    QVERIFY(db.execute(QStringLiteral("CREATE TABLE ztokenmetainformation"
+                                      "  (z_pk INTEGER PRIMARY KEY, zfile INTEGER, zanchor TEXT)")));
+    QVERIFY(db.execute(QStringLiteral("CREATE TABLE ztoken"
+                                      "  (z_pk INTEGER PRIMARY KEY, ztokenname TEXT, ztokentype INTEGER,"
+                                      "  zmetainformation INTEGER)")));
+    QVERIFY(db.execute(QStringLiteral("INSERT INTO ztokentype VALUES (1, 'Class'), (2, 'Method')")));
+    QVERIFY(db.execute(QStringLiteral("INSERT INTO zfilepath VALUES (1, 'qstring.html'), (2, 'qhash.html')")));
+    QVERIFY(db.execute(QStringLiteral("INSERT INTO ztokenmetainformation VALUES (1, 1, NULL), (2, 1, 'arg'),"
+                                      "  (3, 2, NULL)")));
+    QVERIFY(db.execute(QStringLiteral("INSERT INTO ztoken VALUES (1, 'QString', 1, 1), (2, 'QString::arg', 2, 2),"
+                                      "  (3, 'qHash', 2, 3)")));
+}
+
+QStringList NameIndexTest::indexNames(Database &db, const QString &table)
+{
+    Statement stmt(db, QStringLiteral("PRAGMA INDEX_LIST('%1')").arg(table));
+
+    QStringList result;
+    while (stmt.step()) {
+        result.append(stmt.value(1).toString());
+    }
+
+    return result;
+}
+
+QStringList NameIndexTest::names(Database &db)
+{
+    Statement stmt(db, QStringLiteral("SELECT name FROM searchIndex ORDER BY name COLLATE NOCASE, name"));
+
+    QStringList result;
+    while (stmt.step()) {
+        result.append(stmt.value(0).toString());
+    }
+
+    return result;
+}
+
+QTEST_MAIN(NameIndexTest)
+
+#include "nameindex_test.moc"
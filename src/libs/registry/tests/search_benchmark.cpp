@@ -0,0 +1,142 @@
+// Copyright (C) Oleg Shparber, et al. <https://zealdocs.org>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "docsetgenerator.h"
+
+#include "../docsetregistry.h"
+
+#include <core/httpserver.h>
+
+#include <QtTest>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+using namespace Zeal;
+using namespace Zeal::Registry;
+
+// End-to-end DocsetRegistry::search() latency while typing queries, on
+// generated Dash and ZDash docsets. Not part of the test suite; run
+// search_benchmark directly. ZEAL_BENCHMARK_SYMBOLS sets the number of symbols
+// per docset (10000-2000000, default 100000).
+class SearchBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void benchmarkTyping_data();
+    void benchmarkTyping();
+
+private:
+    static double percentile(const QList<double> &sorted, double p);
+
+    QTemporaryDir m_dir;
+    std::unique_ptr<Core::HttpServer> m_httpServer;
+    std::unique_ptr<DocsetRegistry> m_registry;
+};
+
+void SearchBenchmark::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+
+    int symbolCount = qEnvironmentVariableIntValue("ZEAL_BENCHMARK_SYMBOLS");
+    symbolCount = symbolCount > 0 ? std::clamp(symbolCount, 10000, 2000000) : 100000;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    const QString dashPath = Tests::generateDocset(m_dir.path(), QStringLiteral("Dash"), Tests::DocsetFormat::Dash,
+                                                   symbolCount);
+    const QString zdashPath = Tests::generateDocset(m_dir.path(), QStringLiteral("ZDash"),
+                                                    Tests::DocsetFormat::ZDash, symbolCount);
+    QVERIFY(!dashPath.isEmpty());
+    QVERIFY(!zdashPath.isEmpty());
+
+    qInfo("Generated 2 x %d symbols in %lld ms.", symbolCount, timer.restart());
+
+    m_httpServer = std::make_unique<Core::HttpServer>();
+    m_registry = std::make_unique<DocsetRegistry>(m_httpServer.get());
+    m_registry->setMaxResults(300);
+    m_registry->loadDocset(dashPath);
+    m_registry->loadDocset(zdashPath);
+    QCOMPARE(m_registry->count(), 2);
+
+    qInfo("Loaded docsets in %lld ms.", timer.elapsed());
+}
+
+void SearchBenchmark::cleanupTestCase()
+{
+    m_registry.reset();
+    m_httpServer.reset();
+}
+
+void SearchBenchmark::benchmarkTyping_data()
+{
+    QTest::addColumn<QString>("keyword");
+    QTest::addColumn<bool>("isFuzzy");
+
+    for (const QString &keyword : {QStringLiteral("dash"), QStringLiteral("zdash")}) {
+        QTest::addRow("%s/substring", qPrintable(keyword)) << keyword << false;
+        QTest::addRow("%s/fuzzy", qPrintable(keyword)) << keyword << true;
+    }
+}
+
+void SearchBenchmark::benchmarkTyping()
+{
+    QFETCH(QString, keyword);
+    QFETCH(bool, isFuzzy);
+
+    // Typed one character at a time, as the search box sends them.
+    static const QStringList words = {
+        QStringLiteral("getValue"),
+        QStringLiteral("TreeView"),
+        QStringLiteral("list::append"),
+        QStringLiteral("read_file"),
+        QStringLiteral("qzx"),
+    };
+
+    m_registry->setFuzzySearchEnabled(isFuzzy);
+
+    QSignalSpy spy(m_registry.get(), &DocsetRegistry::searchCompleted);
+
+    QList<double> latencies;
+    for (const QString &word : words) {
+        for (int i = 1; i <= word.size(); ++i) {
+            const QString query = keyword + QLatin1Char(':') + word.left(i);
+
+            QElapsedTimer timer;
+            timer.start();
+            m_registry->search(query);
+            QVERIFY(spy.wait(60000));
+            latencies.append(static_cast<double>(timer.nsecsElapsed()) / 1e6);
+
+            spy.clear();
+        }
+    }
+
+    std::ranges::sort(latencies);
+
+    qInfo("%d queries: p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, max %.2f ms",
+          static_cast<int>(latencies.size()),
+          percentile(latencies, 0.5),
+          percentile(latencies, 0.9),
+          percentile(latencies, 0.99),
+          latencies.constLast());
+
+    QTest::setBenchmarkResult(percentile(latencies, 0.5), QTest::WalltimeMilliseconds);
+}
+
+double SearchBenchmark::percentile(const QList<double> &sorted, double p)
+{
+    // Nearest rank.
+    const auto rank = static_cast<qsizetype>(std::ceil(p * static_cast<double>(sorted.size())));
+    return sorted.at(std::clamp<qsizetype>(rank - 1, 0, sorted.size() - 1));
+}
+
+QTEST_MAIN(SearchBenchmark)
+
+#include "search_benchmark.moc"
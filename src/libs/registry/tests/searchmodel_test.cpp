@@ -0,0 +1,184 @@
+// Copyright (C) Oleg Shparber, et al. <https://zealdocs.org>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "../itemdatarole.h"
+#include "../searchmodel.h"
+
+#include <QSignalSpy>
+#include <QtTest>
+
+using namespace Zeal::Registry;
+
+class SearchModelTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testMergeIntoEmptyModel();
+    void testMergeInterleavesResults();
+    void testMergeDoesNotResetModel();
+    void testMergeRespectsLimit();
+    void testFuzzyMatchPositions();
+    void testSubstringMatchPositions();
+    void testMatchPositionsFollowRows();
+    void testUrlIsBuiltOnDemand();
+    void testInternedIds();
+
+private:
+    static SearchResult result(const QString &name, double score);
+    static QStringList names(const SearchModel &model);
+};
+
+void SearchModelTest::testMergeIntoEmptyModel()
+{
+    SearchModel model;
+    model.mergeResults({result(QStringLiteral("a"), 3), result(QStringLiteral("b"), 2)});
+
+    QCOMPARE(names(model), (QStringList{QStringLiteral("a"), QStringLiteral("b")}));
+}
+
+void SearchModelTest::testMergeInterleavesResults()
+{
+    SearchModel model;
+    model.setResults({result(QStringLiteral("a"), 5), result(QStringLiteral("c"), 3), result(QStringLiteral("e"), 1)});
+    model.mergeResults({result(QStringLiteral("b"), 4), result(QStringLiteral("d"), 2), result(QStringLiteral("f"), 0)});
+
+    QCOMPARE(names(model),
+             (QStringList{QStringLiteral("a"),
+                          QStringLiteral("b"),
+                          QStringLiteral("c"),
+                          QStringLiteral("d"),
+                          QStringLiteral("e"),
+                          QStringLiteral("f")}));
+}
+
+void SearchModelTest::testMergeDoesNotResetModel()
+{
+    SearchModel model;
+    model.setResults({result(QStringLiteral("a"), 5), result(QStringLiteral("c"), 3)});
+
+    QSignalSpy resetSpy(&model, &SearchModel::modelReset);
+    QSignalSpy insertSpy(&model, &SearchModel::rowsInserted);
+    model.mergeResults({result(QStringLiteral("b"), 4)});
+
+    QCOMPARE(resetSpy.count(), 0);
+    QCOMPARE(insertSpy.count(), 1);
+    QCOMPARE(insertSpy.first().at(1).toInt(), 1);
+    QCOMPARE(insertSpy.first().at(2).toInt(), 1);
+}
+
+void SearchModelTest::testMergeRespectsLimit()
+{
+    SearchModel model;
+    model.setResults({result(QStringLiteral("a"), 5), result(QStringLiteral("c"), 3)});
+    model.mergeResults({result(QStringLiteral("b"), 4), result(QStringLiteral("d"), 2)}, 3);
+
+    QCOMPARE(names(model), (QStringList{QStringLiteral("a"), QStringLiteral("b"), QStringLiteral("c")}));
+}
+
+void SearchModelTest::testFuzzyMatchPositions()
+{
+    SearchModel model;
+    model.setMatchQuery(QStringLiteral("qsa"), true);
+    model.setResults({result(QStringLiteral("QString::arg"), 1)});
+
+    QCOMPARE(model.index(0, 0, QModelIndex()).data(ItemDataRole::MatchPositionsRole).value<QList<int>>(),
+             (QList<int>{0, 1, 9}));
+}
+
+void SearchModelTest::testSubstringMatchPositions()
+{
+    SearchModel model;
+    model.setMatchQuery(QStringLiteral("STR"), false);
+    model.setResults({result(QStringLiteral("QString"), 1)});
+
+    QCOMPARE(model.index(0, 0, QModelIndex()).data(ItemDataRole::MatchPositionsRole).value<QList<int>>(),
+             (QList<int>{1, 2, 3}));
+
+    // No query, no highlighting.
+    model.setMatchQuery(QString(), false);
+    QVERIFY(model.index(0, 0, QModelIndex()).data(ItemDataRole::MatchPositionsRole).value<QList<int>>().isEmpty());
+}
+
+void SearchModelTest::testMatchPositionsFollowRows()
+{
+    SearchModel model;
+    model.setMatchQuery(QStringLiteral("b"), false);
+    model.setResults({result(QStringLiteral("ab"), 2)});
+
+    // Computed for row 0, which then moves to row 1.
+    QCOMPARE(model.index(0, 0, QModelIndex()).data(ItemDataRole::MatchPositionsRole).value<QList<int>>(),
+             QList<int>{1});
+    model.mergeResults({result(QStringLiteral("b"), 3)});
+
+    QCOMPARE(model.index(0, 0, QModelIndex()).data(ItemDataRole::MatchPositionsRole).value<QList<int>>(),
+             QList<int>{0});
+    QCOMPARE(model.index(1, 0, QModelIndex()).data(ItemDataRole::MatchPositionsRole).value<QList<int>>(),
+             QList<int>{1});
+}
+
+void SearchModelTest::testUrlIsBuiltOnDemand()
+{
+    SearchResult pathOnly = result(QStringLiteral("QString"), 1);
+    pathOnly.docsetId
+        = SearchResult::internDocset(QStringLiteral("Qt_6"), QIcon(), QUrl(QStringLiteral("http://127.0.0.1:8080/Qt_6")));
+    pathOnly.path = QStringLiteral("qstring.html#arg<dash_entry_name=arg>");
+
+    SearchResult withFragment = result(QStringLiteral("QString::arg"), 0);
+    withFragment.docsetId = pathOnly.docsetId;
+    withFragment.path = QStringLiteral("qstring.html");
+    withFragment.fragment = QStringLiteral("arg");
+
+    SearchModel model;
+    model.setResults({pathOnly, withFragment});
+
+    QCOMPARE(model.index(0, 0, QModelIndex()).data(ItemDataRole::UrlRole).toUrl(),
+             QUrl(QStringLiteral("http://127.0.0.1:8080/Qt_6/qstring.html#arg")));
+    QCOMPARE(model.index(1, 0, QModelIndex()).data(ItemDataRole::UrlRole).toUrl(),
+             QUrl(QStringLiteral("http://127.0.0.1:8080/Qt_6/qstring.html#arg")));
+}
+
+void SearchModelTest::testInternedIds()
+{
+    const quint16 classId = SearchResult::internSymbolType(QStringLiteral("Class"));
+    QVERIFY(classId != 0);
+    QCOMPARE(SearchResult::internSymbolType(QStringLiteral("Class")), classId);
+    QVERIFY(SearchResult::internSymbolType(QStringLiteral("Method")) != classId);
+    QCOMPARE(SearchResult::internSymbolType(QString()), quint16(0));
+
+    // Re-interning a docset keeps its id and updates its base URL.
+    const quint16 docsetId = SearchResult::internDocset(QStringLiteral("Intern"), QIcon(), QUrl());
+    const QUrl baseUrl(QStringLiteral("http://127.0.0.1:8080/Intern"));
+    QCOMPARE(SearchResult::internDocset(QStringLiteral("Intern"), QIcon(), baseUrl), docsetId);
+
+    SearchResult item = result(QStringLiteral("QString"), 1);
+    item.typeId = classId;
+    item.docsetId = docsetId;
+
+    QCOMPARE(item.type(), QStringLiteral("Class"));
+    QCOMPARE(item.docsetName(), QStringLiteral("Intern"));
+    QCOMPARE(item.docsetBaseUrl(), baseUrl);
+
+    // Id 0 resolves to nothing.
+    QVERIFY(result(QStringLiteral("QString"), 1).docsetName().isEmpty());
+}
+
+SearchResult SearchModelTest::result(const QString &name, double score)
+{
+    SearchResult result;
+    result.name = name;
+    result.score = score;
+    return result;
+}
+
+QStringList SearchModelTest::names(const SearchModel &model)
+{
+    QStringList result;
+    for (int row = 0; row < model.rowCount(); ++row) {
+        result.append(model.index(row, 0, QModelIndex()).data().toString());
+    }
+    return result;
+}
+
+QTEST_MAIN(SearchModelTest)
+#include "searchmodel_test.moc"
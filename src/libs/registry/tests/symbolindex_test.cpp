@@ -0,0 +1,221 @@
+// Copyright (C) Oleg Shparber, et al. <https://zealdocs.org>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "../symbolindex.h"
+
+#include <QtTest>
+
+#include <algorithm>
+#include <memory>
+
+using namespace Zeal::Registry;
+
+class SymbolIndexTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+
+    void testColumns();
+    void testTypeInterning();
+    void testFuzzySearch();
+    void testSubstringSearch();
+    void testSubstringSearchIsCaseInsensitive();
+    void testEmptyQueryListsByName();
+    void testLimitKeepsBestMatches();
+    void testLimitedMatchesAreSortedByScore();
+    void testLimitBreaksTiesByName_data();
+    void testLimitBreaksTiesByName();
+    void testCanceledSearchReturnsNothing();
+    void testMatchedRowsIgnoreLimit();
+    void testFuzzyLimitSkipsRowsThatCannotWin();
+    void testCandidatesNarrowScan();
+
+private:
+    static QStringList names(const SymbolIndex &index, const QList<SymbolIndex::Match> &matches);
+
+    std::unique_ptr<SymbolIndex> m_index;
+};
+
+void SymbolIndexTest::init()
+{
+    m_index = std::make_unique<SymbolIndex>();
+    m_index->append(u"QString", QStringLiteral("Class"), u"qstring.html", {});
+    m_index->append(u"QString::arg", QStringLiteral("Method"), u"qstring.html", u"arg");
+    m_index->append(u"QStringList", QStringLiteral("Class"), u"qstringlist.html", {});
+    m_index->append(u"qHash", QStringLiteral("Function"), u"qhash.html#qHash", {});
+    m_index->squeeze();
+}
+
+void SymbolIndexTest::testColumns()
+{
+    QCOMPARE(m_index->size(), 4);
+    QVERIFY(!m_index->isEmpty());
+
+    QCOMPARE(m_index->name(1).toString(), QStringLiteral("QString::arg"));
+    QCOMPARE(m_index->lowerName(1).toString(), QStringLiteral("qstring::arg"));
+    QCOMPARE(m_index->type(1), QStringLiteral("Method"));
+    QCOMPARE(m_index->path(1).toString(), QStringLiteral("qstring.html"));
+    QCOMPARE(m_index->fragment(1).toString(), QStringLiteral("arg"));
+
+    QCOMPARE(m_index->path(3).toString(), QStringLiteral("qhash.html#qHash"));
+    QVERIFY(m_index->fragment(3).isEmpty());
+}
+
+void SymbolIndexTest::testTypeInterning()
+{
+    QCOMPARE(m_index->type(0), QStringLiteral("Class"));
+    QCOMPARE(m_index->type(2), QStringLiteral("Class"));
+
+    // Interned types share storage.
+    QCOMPARE(&m_index->type(0), &m_index->type(2));
+}
+
+void SymbolIndexTest::testFuzzySearch()
+{
+    const std::atomic_bool canceled{false};
+    const auto matches = m_index->search(QStringLiteral("qsa"), true, 0, canceled);
+
+    QCOMPARE(names(*m_index, matches), QStringList{QStringLiteral("QString::arg")});
+    QVERIFY(matches.first().score > 0);
+}
+
+void SymbolIndexTest::testSubstringSearch()
+{
+    const std::atomic_bool canceled{false};
+    const auto matches = m_index->search(QStringLiteral("string"), false, 0, canceled);
+
+    QCOMPARE(names(*m_index, matches),
+             (QStringList{QStringLiteral("QString"), QStringLiteral("QString::arg"), QStringLiteral("QStringList")}));
+
+    // Substring matches score -length(name), as in SQL.
+    QCOMPARE(matches.at(0).score, -7.0);
+    QCOMPARE(matches.at(2).score, -11.0);
+}
+
+void SymbolIndexTest::testSubstringSearchIsCaseInsensitive()
+{
+    const std::atomic_bool canceled{false};
+    const auto matches = m_index->search(QStringLiteral("HASH"), false, 0, canceled);
+
+    QCOMPARE(names(*m_index, matches), QStringList{QStringLiteral("qHash")});
+}
+
+void SymbolIndexTest::testEmptyQueryListsByName()
+{
+    const std::atomic_bool canceled{false};
+    const auto matches = m_index->search(QString(), true, 2, canceled);
+
+    // Case-insensitively, like SearchResult.
+    QCOMPARE(names(*m_index, matches), (QStringList{QStringLiteral("qHash"), QStringLiteral("QString")}));
+}
+
+void SymbolIndexTest::testLimitKeepsBestMatches()
+{
+    const std::atomic_bool canceled{false};
+    const auto matches = m_index->search(QStringLiteral("string"), false, 1, canceled);
+
+    QCOMPARE(names(*m_index, matches), QStringList{QStringLiteral("QString")});
+}
+
+void SymbolIndexTest::testLimitedMatchesAreSortedByScore()
+{
+    const std::atomic_bool canceled{false};
+    const auto matches = m_index->search(QStringLiteral("string"), false, 2, canceled);
+
+    // QString::arg (-12) is scanned before QStringList (-11), but is dropped.
+    QCOMPARE(names(*m_index, matches), (QStringList{QStringLiteral("QString"), QStringLiteral("QStringList")}));
+}
+
+void SymbolIndexTest::testLimitBreaksTiesByName_data()
+{
+    QTest::addColumn<bool>("fuzzy");
+
+    QTest::newRow("substring") << false;
+    QTest::newRow("fuzzy") << true;
+}
+
+void SymbolIndexTest::testLimitBreaksTiesByName()
+{
+    QFETCH(bool, fuzzy);
+
+    // Names that score the same, in no particular order.
+    SymbolIndex index;
+    for (const char16_t *name : {u"setD", u"SetC", u"setA", u"SETB", u"setE"}) {
+        index.append(name, QStringLiteral("Method"), u"set.html", {});
+    }
+
+    const std::atomic_bool canceled{false};
+    QStringList all = names(index, index.search(QStringLiteral("set"), fuzzy, 0, canceled));
+    QCOMPARE(all.size(), 5);
+
+    // A limited search keeps what a full one would sort first.
+    std::ranges::sort(all, [](const QString &lhs, const QString &rhs) {
+        return QString::compare(lhs, rhs, Qt::CaseInsensitive) < 0;
+    });
+
+    for (int limit = 1; limit <= 5; ++limit) {
+        QCOMPARE(names(index, index.search(QStringLiteral("set"), fuzzy, limit, canceled)), all.first(limit));
+    }
+}
+
+void SymbolIndexTest::testCanceledSearchReturnsNothing()
+{
+    const std::atomic_bool canceled{true};
+    QVERIFY(m_index->search(QStringLiteral("string"), false, 0, canceled).isEmpty());
+    QVERIFY(m_index->search(QStringLiteral("string"), true, 0, canceled).isEmpty());
+}
+
+void SymbolIndexTest::testMatchedRowsIgnoreLimit()
+{
+    const std::atomic_bool canceled{false};
+    QList<int> matchedRows;
+    const auto matches = m_index->search(QStringLiteral("string"), false, 1, canceled, nullptr, &matchedRows);
+
+    QCOMPARE(matches.size(), 1);
+    QCOMPARE(matchedRows, (QList<int>{0, 1, 2}));
+}
+
+void SymbolIndexTest::testFuzzyLimitSkipsRowsThatCannotWin()
+{
+    const std::atomic_bool canceled{false};
+    QList<int> matchedRows;
+
+    // Once QString is kept, the longer names cannot outscore it and are not
+    // scored, but they still match the query.
+    const auto matches = m_index->search(QStringLiteral("qstr"), true, 1, canceled, nullptr, &matchedRows);
+    QCOMPARE(names(*m_index, matches), QStringList{QStringLiteral("QString")});
+    QCOMPARE(matchedRows, (QList<int>{0, 1, 2}));
+
+    // QString::arg is scored, then displaced by the shorter QStringList.
+    const auto best = m_index->search(QStringLiteral("qs"), true, 2, canceled);
+    QCOMPARE(names(*m_index, best), (QStringList{QStringLiteral("QString"), QStringLiteral("QStringList")}));
+}
+
+void SymbolIndexTest::testCandidatesNarrowScan()
+{
+    const std::atomic_bool canceled{false};
+    QList<int> matchedRows;
+    m_index->search(QStringLiteral("qs"), true, 0, canceled, nullptr, &matchedRows);
+    QCOMPARE(matchedRows, (QList<int>{0, 1, 2, 3}));
+
+    // Rows outside the candidate set are never considered.
+    const QList<int> candidates{1, 2};
+    const auto matches = m_index->search(QStringLiteral("qstring"), true, 0, canceled, &candidates, &matchedRows);
+
+    QCOMPARE(names(*m_index, matches), (QStringList{QStringLiteral("QString::arg"), QStringLiteral("QStringList")}));
+    QCOMPARE(matchedRows, candidates);
+}
+
+QStringList SymbolIndexTest::names(const SymbolIndex &index, const QList<SymbolIndex::Match> &matches)
+{
+    QStringList result;
+    for (const SymbolIndex::Match &match : matches) {
+        result.append(index.name(match.row).toString());
+    }
+    return result;
+}
+
+QTEST_MAIN(SymbolIndexTest)
+#include "symbolindex_test.moc"
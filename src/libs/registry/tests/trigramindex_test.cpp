@@ -0,0 +1,177 @@
+// Copyright (C) Oleg Shparber, et al. <https://zealdocs.org>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "../trigramindex.h"
+
+#include <util/database.h>
+#include <util/statement.h>
+
+#include <QtTest>
+
+#include <memory>
+
+using namespace Zeal::Registry;
+using namespace Zeal::Util;
+
+class TrigramIndexTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+
+    void testSubstringSearch();
+    void testQueryIsQuoted();
+    void testShortQueryIsRejected();
+    void testLimit();
+    void testStaleIndexIsRebuilt();
+    void testZDashSymbolTables();
+    void testFailedBuild();
+
+private:
+    std::unique_ptr<TrigramIndex> createIndex() const;
+    static QStringList search(const TrigramIndex &index, const QString &query, int limit = 0);
+
+    std::unique_ptr<QTemporaryDir> m_dir;
+    QString m_sourcePath;
+    QString m_indexPath;
+};
+
+void TrigramIndexTest::init()
+{
+    m_dir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_dir->isValid());
+
+    m_sourcePath = m_dir->filePath(QStringLiteral("docSet.dsidx"));
+    m_indexPath = m_dir->filePath(QStringLiteral("cache/docset.sqlite"));
+
+    Database db(m_sourcePath);
+    QVERIFY(db.execute(QStringLiteral("CREATE TABLE searchIndex (id INTEGER PRIMARY KEY, name TEXT, type TEXT, path TEXT)")));
+    QVERIFY(db.execute(QStringLiteral("INSERT INTO searchIndex (name, type, path) VALUES"
+                                      "  ('QString', 'Class', 'qstring.html'),"
+                                      "  ('QString::arg', 'Method', 'qstring.html#arg'),"
+                                      "  ('QStringList', 'Class', 'qstringlist.html'),"
+                                      "  ('say \"hi\"', 'Guide', 'quotes.html'),"
+                                      "  ('qHash', 'Function', 'qhash.html')")));
+}
+
+void TrigramIndexTest::testSubstringSearch()
+{
+    const auto index = createIndex();
+    QTRY_VERIFY(index->isReady());
+
+    // Shortest names first, like the LIKE scan.
+    QCOMPARE(search(*index, QStringLiteral("string")),
+             QStringList({QStringLiteral("QString"), QStringLiteral("QStringList"), QStringLiteral("QString::arg")}));
+    QCOMPARE(search(*index, QStringLiteral("HASH")), QStringList({QStringLiteral("qHash")}));
+    QVERIFY(search(*index, QStringLiteral("missing")).isEmpty());
+}
+
+void TrigramIndexTest::testQueryIsQuoted()
+{
+    const auto index = createIndex();
+    QTRY_VERIFY(index->isReady());
+
+    QCOMPARE(search(*index, QStringLiteral("\"hi\"")), QStringList({QStringLiteral("say \"hi\"")}));
+    QVERIFY(search(*index, QStringLiteral("arg OR qHash")).isEmpty());
+}
+
+void TrigramIndexTest::testShortQueryIsRejected()
+{
+    const auto index = createIndex();
+    QTRY_VERIFY(index->isReady());
+
+    const std::atomic_bool canceled{false};
+    QVERIFY(!index->search(QStringLiteral("QS"), 0, canceled, [](const Statement &) {}));
+}
+
+void TrigramIndexTest::testLimit()
+{
+    const auto index = createIndex();
+    QTRY_VERIFY(index->isReady());
+
+    QCOMPARE(search(*index, QStringLiteral("string"), 1), QStringList({QStringLiteral("QString")}));
+}
+
+void TrigramIndexTest::testStaleIndexIsRebuilt()
+{
+    {
+        const auto index = createIndex();
+        QTRY_VERIFY(index->isReady());
+    }
+
+    {
+        Database db(m_sourcePath);
+        QVERIFY(db.execute(QStringLiteral("INSERT INTO searchIndex (name, type, path) VALUES"
+                                          "  ('QStringView', 'Class', 'qstringview.html')")));
+    }
+
+    const auto index = createIndex();
+    QTRY_VERIFY(index->isReady());
+
+    QVERIFY(search(*index, QStringLiteral("string")).contains(QStringLiteral("QStringView")));
+}
+
+void TrigramIndexTest::testZDashSymbolTables()
+{
+    // Without a persistent searchIndex view, like a ZDash docset on read-only storage.
+    const QString sourcePath = m_dir->filePath(QStringLiteral("zdash.dsidx"));
+    {
+        Database db(sourcePath);
+        QVERIFY(db.execute(QStringLiteral("CREATE TABLE ztokentype (z_pk INTEGER PRIMARY KEY, ztypename TEXT)")));
+        QVERIFY(db.execute(QStringLiteral("CREATE TABLE zfilepath (z_pk INTEGER PRIMARY KEY, zpath TEXT)")));
+        QVERIFY(db.execute(QStringLiteral("CREATE TABLE ztokenmetainformation"
+                                          "  (z_pk INTEGER PRIMARY KEY, zfile INTEGER, zanchor TEXT)")));
+        QVERIFY(db.execute(QStringLiteral("CREATE TABLE ztoken"
+                                          "  (z_pk INTEGER PRIMARY KEY, ztokenname TEXT, ztokentype INTEGER,"
+                                          "  zmetainformation INTEGER)")));
+        QVERIFY(db.execute(QStringLiteral("INSERT INTO ztokentype VALUES (1, 'Class'), (2, 'Method')")));
+        QVERIFY(db.execute(QStringLiteral("INSERT INTO zfilepath VALUES (1, 'qstring.html')")));
+        QVERIFY(db.execute(QStringLiteral("INSERT INTO ztokenmetainformation VALUES (1, 1, NULL), (2, 1, 'arg')")));
+        QVERIFY(db.execute(QStringLiteral("INSERT INTO ztoken VALUES"
+                                          "  (1, 'QString', 1, 1), (2, 'QString::arg', 2, 2)")));
+    }
+
+    const TrigramIndex index(QStringLiteral("Test"), sourcePath, true, m_indexPath);
+    QTRY_VERIFY(index.isReady());
+    QVERIFY(!index.hasFailed());
+
+    QCOMPARE(search(index, QStringLiteral("string")),
+             QStringList({QStringLiteral("QString"), QStringLiteral("QString::arg")}));
+}
+
+void TrigramIndexTest::testFailedBuild()
+{
+    // A Dash docset without its searchIndex table.
+    const QString sourcePath = m_dir->filePath(QStringLiteral("broken.dsidx"));
+    {
+        Database db(sourcePath);
+        QVERIFY(db.execute(QStringLiteral("CREATE TABLE other (name TEXT)")));
+    }
+
+    const TrigramIndex index(QStringLiteral("Test"), sourcePath, false, m_indexPath);
+    QTRY_VERIFY(index.hasFailed());
+    QVERIFY(!index.isReady());
+    QVERIFY(!QFile::exists(m_indexPath));
+}
+
+std::unique_ptr<TrigramIndex> TrigramIndexTest::createIndex() const
+{
+    return std::make_unique<TrigramIndex>(QStringLiteral("Test"), m_sourcePath, false, m_indexPath);
+}
+
+QStringList TrigramIndexTest::search(const TrigramIndex &index, const QString &query, int limit)
+{
+    const std::atomic_bool canceled{false};
+
+    QStringList names;
+    const bool ok = index.search(query, limit, canceled, [&names](const Statement &stmt) {
+        names.append(stmt.value(0).toString());
+    });
+
+    return ok ? names : QStringList();
+}
+
+QTEST_MAIN(TrigramIndexTest)
+
+#include "trigramindex_test.moc"
@@ -0,0 +1,245 @@
+// Copyright (C) Oleg Shparber, et al. <https://zealdocs.org>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "trigramindex.h"
+
+#include "indexbuild.h"
+
+#include <util/database.h>
+#include <util/statement.h>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLoggingCategory>
+#include <QMutexLocker>
+#include <QScopeGuard>
+#include <QtConcurrent>
+
+#include <sqlite3.h>
+
+#include <algorithm>
+
+namespace Zeal::Registry {
+
+namespace {
+Q_LOGGING_CATEGORY(log, "zeal.registry.trigramindex")
+
+// Bump when the sidecar schema changes, so existing files are rebuilt.
+constexpr int FormatVersion = 1;
+
+// Name index builds lock the docset database while committing, see NameIndex.
+constexpr int BusyTimeout = 10000; // ms
+
+// Reads the symbol tables themselves, since the searchIndex view of a ZDash
+// docset may only exist on the docset connection.
+QString symbolQuery(bool isZDash)
+{
+    if (!isZDash) {
+        return QStringLiteral("SELECT name, type, path, '' FROM source.searchIndex");
+    }
+
+    return QStringLiteral("SELECT ztokenname, ztypename, zpath, zanchor"
+                          "  FROM source.ztoken"
+                          "  INNER JOIN source.ztokenmetainformation"
+                          "    ON ztoken.zmetainformation = ztokenmetainformation.z_pk"
+                          "  INNER JOIN source.zfilepath"
+                          "    ON ztokenmetainformation.zfile = zfilepath.z_pk"
+                          "  INNER JOIN source.ztokentype"
+                          "    ON ztoken.ztokentype = ztokentype.z_pk");
+}
+} // namespace
+
+TrigramIndex::TrigramIndex(const QString &docsetName, const QString &sourcePath, bool isZDash, const QString &path)
+    : m_docsetName(docsetName)
+    , m_sourcePath(sourcePath)
+    , m_isZDash(isZDash)
+    , m_path(path)
+{
+    m_buildFuture = QtConcurrent::run(IndexBuild::threadPool(), [this]() {
+        build();
+    });
+}
+
+TrigramIndex::~TrigramIndex()
+{
+    m_isBuildCanceled.store(true, std::memory_order_relaxed);
+
+    {
+        const QMutexLocker locker(&m_buildMutex);
+        if (m_buildDb != nullptr) {
+            sqlite3_interrupt(m_buildDb->handle());
+        }
+    }
+
+    m_buildFuture.waitForFinished();
+}
+
+bool TrigramIndex::isReady() const
+{
+    return m_isReady.load(std::memory_order_acquire);
+}
+
+bool TrigramIndex::hasFailed() const
+{
+    return m_hasFailed.load(std::memory_order_acquire);
+}
+
+bool TrigramIndex::search(const QString &query,
+                          int limit,
+                          const std::atomic_bool &canceled,
+                          const std::function<void(const Util::Statement &)> &addRow) const
+{
+    if (!isReady() || query.size() < MinQueryLength) {
+        return false;
+    }
+
+    // A quoted FTS5 string is a single phrase, which the trigram tokenizer
+    // matches as a substring. Quotes inside it are escaped by doubling.
+    QString phrase = query;
+    phrase.replace(QLatin1Char('"'), QLatin1String("\"\""));
+    phrase.prepend(QLatin1Char('"')).append(QLatin1Char('"'));
+
+    Util::Statement stmt(*m_db,
+                         QStringLiteral("SELECT name, type, path, fragment, -length(name) AS score"
+                                        "  FROM symbols"
+                                        "  WHERE name MATCH ?"
+                                        "  ORDER BY score DESC, name COLLATE NOCASE"
+                                        "  LIMIT ?"));
+    if (!stmt.isValid()) {
+        qCWarning(log, "[%s] Cannot query trigram index: %s", qPrintable(m_docsetName), qPrintable(stmt.lastError()));
+        return false;
+    }
+
+    stmt.bindText(1, phrase);
+    stmt.bindInt(2, limit > 0 ? limit : -1);
+
+    m_db->setInterruptFlag(&canceled);
+    const auto interruptFlagGuard = qScopeGuard([this]() {
+        m_db->setInterruptFlag(nullptr);
+    });
+
+    while (stmt.step() && !canceled.load(std::memory_order_relaxed)) {
+        addRow(stmt);
+    }
+
+    return true;
+}
+
+void TrigramIndex::build()
+{
+    if (isUpToDate()) {
+        open();
+        return;
+    }
+
+    qCDebug(log, "[%s] Building trigram index at '%s'.", qPrintable(m_docsetName), qPrintable(m_path));
+
+    QDir().mkpath(QFileInfo(m_path).absolutePath());
+
+    // Taken before reading, so that changes made meanwhile trigger a rebuild.
+    const QList<qint64> sourceStamp = IndexBuild::fileStamp(m_sourcePath);
+
+    // Build into a temporary file, so that an interrupted build never leaves
+    // a sidecar that looks complete.
+    const QString tmpPath = m_path + QLatin1String(".tmp");
+    QFile::remove(tmpPath);
+
+    bool hasTokenizer = false;
+    bool ok = false;
+    QString error;
+
+    {
+        Util::Database db(tmpPath, {.busyTimeout = BusyTimeout});
+        {
+            const QMutexLocker locker(&m_buildMutex);
+            m_buildDb = &db;
+        }
+
+        const auto execute = [this, &db](const QString &sql) {
+            return !m_isBuildCanceled.load(std::memory_order_relaxed) && db.execute(sql);
+        };
+
+        hasTokenizer = db.isOpen()
+                       && execute(QStringLiteral("CREATE VIRTUAL TABLE symbols USING fts5("
+                                                 "  name,"
+                                                 "  type UNINDEXED,"
+                                                 "  path UNINDEXED,"
+                                                 "  fragment UNINDEXED,"
+                                                 "  tokenize = 'trigram')"));
+
+        Util::Statement attach(db, QStringLiteral("ATTACH DATABASE ? AS source"));
+        attach.bindText(1, m_sourcePath);
+
+        ok = hasTokenizer && execute(IndexBuild::createMetaTableQuery())
+             && (attach.step() || attach.lastError().isEmpty()) && execute(QStringLiteral("BEGIN"))
+             && execute(QStringLiteral("INSERT INTO symbols ") + symbolQuery(m_isZDash))
+             && std::ranges::all_of(IndexBuild::setSourceMetaQueries(FormatVersion, sourceStamp), execute)
+             && execute(QStringLiteral("COMMIT"));
+
+        if (!ok) {
+            error = !attach.lastError().isEmpty() ? attach.lastError() : db.lastError();
+        }
+
+        const QMutexLocker locker(&m_buildMutex);
+        m_buildDb = nullptr;
+    }
+
+    if (m_isBuildCanceled.load(std::memory_order_relaxed)) {
+        QFile::remove(tmpPath);
+        return;
+    }
+
+    if (!hasTokenizer) {
+        qCWarning(log,
+                  "[%s] Cannot create trigram index, SQLite may lack FTS5 trigram support: %s",
+                  qPrintable(m_docsetName),
+                  qPrintable(error));
+        QFile::remove(tmpPath);
+        return;
+    }
+
+    if (!ok) {
+        qCWarning(log, "[%s] Cannot build trigram index: %s", qPrintable(m_docsetName), qPrintable(error));
+        QFile::remove(tmpPath);
+        m_hasFailed.store(true, std::memory_order_release);
+        return;
+    }
+
+    QFile::remove(m_path);
+    if (!QFile::rename(tmpPath, m_path)) {
+        qCWarning(log, "[%s] Cannot move trigram index to '%s'.", qPrintable(m_docsetName), qPrintable(m_path));
+        QFile::remove(tmpPath);
+        m_hasFailed.store(true, std::memory_order_release);
+        return;
+    }
+
+    open();
+}
+
+bool TrigramIndex::isUpToDate() const
+{
+    return IndexBuild::isSourceMetaCurrent(IndexBuild::readMeta(m_path),
+                                           FormatVersion,
+                                           IndexBuild::fileStamp(m_sourcePath));
+}
+
+void TrigramIndex::open()
+{
+    // Rebuilds write a new file and rename it over this one, which is never
+    // changed in place.
+    const Util::Database::OpenOptions options{.mode = Util::Database::OpenMode::Immutable};
+    auto db = std::make_unique<Util::Database>(m_path, options);
+    if (!db->isOpen()) {
+        qCWarning(log, "[%s] Cannot open trigram index: %s", qPrintable(m_docsetName), qPrintable(db->lastError()));
+        m_hasFailed.store(true, std::memory_order_release);
+        return;
+    }
+
+    m_db = std::move(db);
+    m_isReady.store(true, std::memory_order_release);
+
+    qCDebug(log, "[%s] Trigram index is ready.", qPrintable(m_docsetName));
+}
+
+} // namespace Zeal::Registry
@@ -0,0 +1,80 @@
+// Copyright (C) Oleg Shparber, et al. <https://zealdocs.org>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef ZEAL_REGISTRY_TRIGRAMINDEX_H
+#define ZEAL_REGISTRY_TRIGRAMINDEX_H
+
+#include <QFuture>
+#include <QMutex>
+#include <QString>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+namespace Zeal {
+
+namespace Util {
+class Database;
+class Statement;
+} // namespace Util
+
+namespace Registry {
+
+// Substring search index for a docset, kept outside of the docset.
+//
+// A sidecar SQLite database with an FTS5 table using the trigram tokenizer,
+// filled from the docset's symbol tables. It turns the
+// `name LIKE '%query%'` full scan into an index lookup. The sidecar records
+// the size and modification time of the docset database and is rebuilt in the
+// background when they change.
+class TrigramIndex final
+{
+    Q_DISABLE_COPY_MOVE(TrigramIndex)
+public:
+    // Trigrams need at least three characters, shorter queries fall back to LIKE.
+    static constexpr int MinQueryLength = 3;
+
+    TrigramIndex(const QString &docsetName, const QString &sourcePath, bool isZDash, const QString &path);
+    ~TrigramIndex();
+
+    bool isReady() const;
+
+    // Whether the build failed for a reason that may go away, e.g. a locked
+    // docset database, so that building again can be tried later. Never set
+    // if SQLite lacks the trigram tokenizer.
+    bool hasFailed() const;
+
+    // Calls addRow for each symbol whose name contains query, best first, with
+    // name, type, path, fragment and score (-length(name)) columns. Returns
+    // false if the index cannot be queried, in which case the caller should
+    // fall back to a LIKE scan.
+    bool search(const QString &query,
+                int limit,
+                const std::atomic_bool &canceled,
+                const std::function<void(const Util::Statement &)> &addRow) const;
+
+private:
+    void build();
+    bool isUpToDate() const;
+    void open();
+
+    QString m_docsetName;
+    QString m_sourcePath;
+    bool m_isZDash = false;
+    QString m_path;
+
+    std::unique_ptr<Util::Database> m_db;
+    std::atomic_bool m_isReady{false};
+    std::atomic_bool m_hasFailed{false};
+
+    QFuture<void> m_buildFuture;
+    std::atomic_bool m_isBuildCanceled{false};
+    QMutex m_buildMutex;
+    Util::Database *m_buildDb = nullptr; // Guarded by m_buildMutex, for interrupting.
+};
+
+} // namespace Registry
+} // namespace Zeal
+
+#endif // ZEAL_REGISTRY_TRIGRAMINDEX_H
@@ -24,6 +24,7 @@
 #include <QWebEngineHistory>
 #include <QWidgetAction>
 
+#include <memory>
 #include <ranges>
 
 namespace Zeal::WidgetUi {
@@ -53,7 +54,7 @@ BrowserTab::BrowserTab(SearchSidebar *sidebarToClone, QWidget *parent)
         if (baseUrl != m_baseUrl) {
             m_baseUrl = baseUrl;
 
-            const Registry::Docset *docset = Core::Application::instance()->docsetRegistry()->docsetForUrl(url);
+            const auto docset = Core::Application::instance()->docsetRegistry()->docsetForUrl(url);
             if (docset) {
                 searchSidebar()->pageTocModel()->setResults(docset->relatedLinks(url));
                 m_webControl->setJavaScriptEnabled(docset->isJavaScriptEnabled());
@@ -185,7 +186,7 @@ BrowserTab::BrowserTab(SearchSidebar *sidebarToClone, QWidget *parent)
     auto *registry = Core::Application::instance()->docsetRegistry();
     using Registry::DocsetRegistry;
     connect(registry, &DocsetRegistry::docsetAboutToBeUnloaded, this, [this, registry](const QString &name) {
-        const Registry::Docset *docset = registry->docsetForUrl(m_webControl->url());
+        const auto docset = registry->docsetForUrl(m_webControl->url());
         if (docset == nullptr || docset->name() != name) {
             return;
         }
@@ -249,7 +250,7 @@ void BrowserTab::search(const Registry::SearchQuery &query)
 
 QIcon BrowserTab::docsetIcon(const QUrl &url)
 {
-    const Registry::Docset *docset = Core::Application::instance()->docsetRegistry()->docsetForUrl(url);
+    const auto docset = Core::Application::instance()->docsetRegistry()->docsetForUrl(url);
     return docset != nullptr ? docset->icon()
                              : QIcon::fromTheme(QStringLiteral("zeal"), QIcon(QStringLiteral(":/zeal.svg")));
 }
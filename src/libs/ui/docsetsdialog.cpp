@@ -77,6 +77,19 @@ DownloadType downloadType(const QNetworkReply *reply)
 {
     return static_cast<DownloadType>(reply->property(DownloadTypeProperty).toInt());
 }
+
+// Docsets are extracted into a hidden folder, and moved into place once complete,
+// so that the storage watcher never sees a partially extracted docset.
+QString stagingDirectoryName(const QString &docsetName)
+{
+    return QStringLiteral(".%1.docset.part").arg(docsetName);
+}
+
+// Removes the staging folder left by an earlier, interrupted installation.
+void removeStagingDirectory(const QString &storagePath, const QString &docsetName)
+{
+    QDir(QDir(storagePath).filePath(stagingDirectoryName(docsetName))).removeRecursively();
+}
 } // namespace
 
 DocsetsDialog::DocsetsDialog(Core::Application *app, QWidget *parent)
@@ -355,7 +368,7 @@ void DocsetsDialog::downloadCompleted()
         }
 
         m_userFeeds[metadata.name()] = metadata;
-        Registry::Docset *docset = m_docsetRegistry->docset(metadata.name());
+        const std::shared_ptr<Registry::Docset> docset = m_docsetRegistry->docset(metadata.name());
         if (docset == nullptr) {
             // Fetch docset only on first feed download,
             // since further downloads are only update checks
@@ -431,7 +444,6 @@ void DocsetsDialog::downloadCompleted()
 
     case DownloadType::TarixIndex: {
         const QString docsetName = reply->property(DocsetNameProperty).toString();
-        const QString docsetDirectoryName = docsetName + QLatin1String(".docset");
 
         const QTemporaryFile *tmpFile = m_tmpFiles.value(docsetName);
         if (tmpFile == nullptr) {
@@ -448,10 +460,11 @@ void DocsetsDialog::downloadCompleted()
             if (indexFile->open() && indexFile->write(indexData) == indexData.size()) {
                 indexFile->close();
                 m_tarixIndexFiles.insert(docsetName, indexFile);
+                removeStagingDirectory(m_application->settings()->docsetPath, docsetName);
                 m_application->extractor()->installTarixDocset(tmpFile->fileName(),
                                                                indexFile->fileName(),
                                                                m_application->settings()->docsetPath,
-                                                               docsetDirectoryName);
+                                                               stagingDirectoryName(docsetName));
                 break;
             }
 
@@ -507,18 +520,29 @@ void DocsetsDialog::extractionCompleted(const QString &filePath)
     const QString docsetName = docsetNameForTmpFilePath(filePath);
 
     const QDir dataDir(m_application->settings()->docsetPath);
+    const QString stagingPath = dataDir.filePath(stagingDirectoryName(docsetName));
     const QString docsetPath = dataDir.filePath(docsetName + QLatin1String(".docset"));
 
     // Write metadata about docset
     Registry::DocsetMetadata metadata = m_availableDocsets.contains(docsetName) ? m_availableDocsets[docsetName]
                                                                                 : m_userFeeds[docsetName];
-    metadata.save(docsetPath, metadata.latestVersion());
+    metadata.save(stagingPath, metadata.latestVersion());
 
-    m_docsetRegistry->loadDocset(docsetPath);
+    const bool isMoved = QDir().rename(stagingPath, docsetPath);
+    if (isMoved) {
+        m_docsetRegistry->loadDocset(docsetPath);
+    } else {
+        qCWarning(log, "Cannot rename '%s' to '%s'.", qPrintable(stagingPath), qPrintable(docsetPath));
+        QDir(stagingPath).removeRecursively();
+        QMessageBox::warning(this,
+                             QStringLiteral("Zeal"),
+                             tr("Cannot install docset <b>%1</b> into <b>%2</b>.")
+                                 .arg(docsetName.toHtmlEscaped(), docsetPath.toHtmlEscaped()));
+    }
 
     QListWidgetItem *listItem = findDocsetListItem(docsetName);
     if (listItem != nullptr) {
-        listItem->setHidden(true);
+        listItem->setHidden(isMoved);
         listItem->setData(DocsetListItemDelegate::ShowProgressRole, false);
     }
 
@@ -537,6 +561,8 @@ void DocsetsDialog::extractionError(const QString &filePath, const QString &erro
                          tr("Cannot extract docset <b>%1</b>: %2")
                              .arg(docsetName.toHtmlEscaped(), errorString.toHtmlEscaped()));
 
+    removeStagingDirectory(m_application->settings()->docsetPath, docsetName);
+
     QListWidgetItem *listItem = findDocsetListItem(docsetName);
     if (listItem != nullptr) {
         listItem->setData(DocsetListItemDelegate::ShowProgressRole, false);
@@ -818,7 +844,7 @@ QListWidgetItem *DocsetsDialog::findDocsetListItem(const QString &name) const
 
 bool DocsetsDialog::updatesAvailable() const
 {
-    return std::ranges::any_of(m_docsetRegistry->docsets(), [](const Registry::Docset *docset) {
+    return std::ranges::any_of(m_docsetRegistry->docsets(), [](const std::shared_ptr<Registry::Docset> &docset) {
         return docset->hasUpdate();
     });
 }
@@ -859,7 +885,7 @@ void DocsetsDialog::cancelDownloads()
 void DocsetsDialog::loadUserFeedList()
 {
     const auto docsets = m_docsetRegistry->docsets();
-    for (const Registry::Docset *docset : docsets) {
+    for (const auto &docset : docsets) {
         if (!docset->feedUrl().isEmpty()) {
             QNetworkReply *reply = download(QUrl(docset->feedUrl()));
             setDownloadType(reply, DownloadType::DashFeed);
@@ -943,14 +969,14 @@ void DocsetsDialog::processDocsetList(const QJsonArray &list)
             listItem->setToolTip(tooltipLines.join(QLatin1Char('\n')));
         }
 
-        if (!m_docsetRegistry->contains(metadata.name())) {
+        // Docsets may be unloaded on the loader thread, so only look them up once.
+        const std::shared_ptr<Registry::Docset> docset = m_docsetRegistry->docset(metadata.name());
+        if (docset == nullptr) {
             continue;
         }
 
         listItem->setHidden(true);
 
-        Registry::Docset *docset = m_docsetRegistry->docset(metadata.name());
-
         if (metadata.latestVersion() != docset->version() || metadata.revision() > docset->revision()) {
             docset->setUpdate(Registry::Docset::UpdateInfo{.version = metadata.latestVersion(),
                                                            .revision = metadata.revision(),
@@ -1078,18 +1104,20 @@ void DocsetsDialog::installDownloadedDocset(const QString &docsetName)
         return;
     }
 
+    removeStagingDirectory(m_application->settings()->docsetPath, docsetName);
     m_application->extractor()->extract(tmpFile->fileName(),
                                         m_application->settings()->docsetPath,
-                                        docsetName + QLatin1String(".docset"));
+                                        stagingDirectoryName(docsetName));
 }
 
 void DocsetsDialog::removeDocset(const QString &name)
 {
-    if (!m_docsetRegistry->contains(name)) {
+    const std::shared_ptr<Registry::Docset> docset = m_docsetRegistry->docset(name);
+    if (docset == nullptr) {
         return;
     }
 
-    const QString docsetPath = m_docsetRegistry->docset(name)->path();
+    const QString docsetPath = docset->path();
     m_docsetRegistry->unloadDocset(name);
     if (!Core::FileManager::removeRecursively(docsetPath)) {
         const QString error = tr("Cannot remove directory <b>%1</b>! It might be in use"
@@ -226,13 +226,17 @@ SearchSidebar::SearchSidebar(const SearchSidebar *other, QWidget *parent)
     // Setup Docset Registry.
     auto *registry = Core::Application::instance()->docsetRegistry();
     using Registry::DocsetRegistry;
-    connect(registry, &DocsetRegistry::searchCompleted, this, [this](const QList<Registry::SearchResult> &results) {
+    connect(registry,
+            &DocsetRegistry::searchCompleted,
+            this,
+            [this, registry](const QList<Registry::SearchResult> &results, const QString &query) {
         if (!isVisible()) {
             return;
         }
 
         m_delayedNavigationTimer->stop();
 
+        m_searchModel->setMatchQuery(query, registry->isFuzzySearchEnabled());
         m_searchModel->setResults(results);
 
         const QModelIndex index = m_searchModel->index(0, 0, QModelIndex());
@@ -245,6 +249,35 @@ SearchSidebar::SearchSidebar(const SearchSidebar *other, QWidget *parent)
         m_delayedNavigationTimer->start();
     });
 
+    connect(registry,
+            &DocsetRegistry::searchResultsAvailable,
+            this,
+            [this, registry](const QList<Registry::SearchResult> &results, bool isFirstBatch, const QString &query) {
+        if (!isVisible()) {
+            return;
+        }
+
+        // Keep following the top result until the delayed navigation happens.
+        const bool isNavigationPending = isFirstBatch || m_delayedNavigationTimer->isActive();
+        m_delayedNavigationTimer->stop();
+
+        if (isFirstBatch) {
+            m_searchModel->setMatchQuery(query, registry->isFuzzySearchEnabled());
+            m_searchModel->setResults(results);
+        } else {
+            m_searchModel->mergeResults(results, registry->maxResults());
+        }
+
+        const QModelIndex index = m_searchModel->index(0, 0, QModelIndex());
+        if (!isNavigationPending || !index.isValid()) {
+            return;
+        }
+
+        m_treeView->setCurrentIndex(index);
+        m_delayedNavigationTimer->setProperty("index", index);
+        m_delayedNavigationTimer->start();
+    });
+
     connect(registry, &DocsetRegistry::docsetAboutToBeUnloaded, this, [this](const QString &name) {
         m_delayedNavigationTimer->stop();
 
@@ -470,15 +503,9 @@ void SearchSidebar::navigateToSelectionWithDelay(const QItemSelection &selection
 
 void SearchSidebar::setupSearchBoxCompletions()
 {
-    QStringList completions;
-    const auto docsets = Core::Application::instance()->docsetRegistry()->docsets();
-    for (const Registry::Docset *docset : docsets) {
-        const QStringList keywords = docset->keywords();
-        if (keywords.isEmpty()) {
-            continue;
-        }
-
-        completions << keywords.constFirst() + QLatin1Char(':');
+    QStringList completions = Core::Application::instance()->docsetRegistry()->keywords();
+    for (QString &completion : completions) {
+        completion += QLatin1Char(':');
     }
 
     if (completions.isEmpty()) {
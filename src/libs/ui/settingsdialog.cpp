@@ -167,6 +167,7 @@ void SettingsDialog::loadSettings()
     ui->toolButton->setKeySequence(settings->showShortcut);
 
     ui->docsetStorageEdit->setText(QDir::toNativeSeparators(settings->docsetPath));
+    ui->docsetStorageWatchCheckBox->setChecked(settings->isDocsetStorageWatchEnabled);
 
     // Tabs Tab
     ui->openNewTabAfterActive->setChecked(settings->openNewTabAfterActive);
@@ -174,6 +175,12 @@ void SettingsDialog::loadSettings()
 
     // Search Tab
     ui->fuzzySearchCheckBox->setChecked(settings->isFuzzySearchEnabled);
+    ui->symbolIndexCheckBox->setChecked(settings->isSymbolIndexEnabled);
+    ui->trigramIndexCheckBox->setChecked(settings->isTrigramIndexEnabled);
+    ui->maxSearchResultsSpinBox->setValue(settings->maxSearchResults);
+    ui->progressiveSearchCheckBox->setChecked(settings->isProgressiveSearchEnabled);
+    ui->lowPrioritySearchCheckBox->setChecked(settings->isLowPrioritySearchEnabled);
+    ui->searchThreadCountSpinBox->setValue(settings->searchThreadCount);
 
     // Content Tab
     for (int i = 0; i < ui->defaultFontComboBox->count(); ++i) {
@@ -261,6 +268,7 @@ void SettingsDialog::saveSettings()
     settings->showShortcut = ui->toolButton->keySequence();
 
     settings->docsetPath = QDir::fromNativeSeparators(ui->docsetStorageEdit->text());
+    settings->isDocsetStorageWatchEnabled = ui->docsetStorageWatchCheckBox->isChecked();
 
     // Tabs Tab
     settings->openNewTabAfterActive = ui->openNewTabAfterActive->isChecked();
@@ -268,6 +276,12 @@ void SettingsDialog::saveSettings()
 
     // Search Tab
     settings->isFuzzySearchEnabled = ui->fuzzySearchCheckBox->isChecked();
+    settings->isSymbolIndexEnabled = ui->symbolIndexCheckBox->isChecked();
+    settings->isTrigramIndexEnabled = ui->trigramIndexCheckBox->isChecked();
+    settings->maxSearchResults = ui->maxSearchResultsSpinBox->value();
+    settings->isProgressiveSearchEnabled = ui->progressiveSearchCheckBox->isChecked();
+    settings->isLowPrioritySearchEnabled = ui->lowPrioritySearchCheckBox->isChecked();
+    settings->searchThreadCount = ui->searchThreadCountSpinBox->value();
 
     // Content Tab
 #if QT_VERSION < QT_VERSION_CHECK(6, 7, 0)
@@ -5,6 +5,7 @@
 #include "database.h"
 
 #include <QMutexLocker>
+#include <QUrl>
 
 #include <sqlite3.h>
 
@@ -24,6 +25,15 @@ constexpr const char *ListViewsSql = "SELECT name"
                                      "  WHERE type='view'"
                                      "  ORDER BY name";
 
+// Number of VM instructions between interrupt flag checks.
+constexpr int InterruptCheckInterval = 256;
+
+// sqlite3_progress_handler() callback, a non-zero result interrupts the statement.
+int interruptCallback(void *flag)
+{
+    return static_cast<const std::atomic_bool *>(flag)->load(std::memory_order_relaxed) ? 1 : 0;
+}
+
 // sqlite3_exec() callback used in tables() and views().
 const auto ListCallback = [](void *ptr, int, char **data, char **) {
     static_cast<QStringList *>(ptr)->append(QString::fromUtf8(*data));
@@ -31,17 +41,41 @@ const auto ListCallback = [](void *ptr, int, char **data, char **) {
 };
 } // namespace
 
-Database::Database(const QString &path)
+Database::Database(const QString &path, const OpenOptions &options)
 {
     if (sqlite3_initialize() != SQLITE_OK) {
         return;
     }
 
-    if (sqlite3_open16(path.constData(), &m_db) != SQLITE_OK) {
+    int rc = SQLITE_OK;
+    if (options.mode == OpenMode::ReadWrite) {
+        rc = sqlite3_open16(path.constData(), &m_db);
+    } else {
+        // Immutability can only be requested through a URI filename.
+        QUrl url = QUrl::fromLocalFile(path);
+        url.setQuery(options.mode == OpenMode::Immutable ? QStringLiteral("immutable=1") : QStringLiteral("mode=ro"));
+        rc = sqlite3_open_v2(url.toEncoded().constData(), &m_db, SQLITE_OPEN_READONLY | SQLITE_OPEN_URI, nullptr);
+    }
+
+    if (rc != SQLITE_OK) {
         if (m_db != nullptr) {
             m_lastError = QString(static_cast<const QChar *>(sqlite3_errmsg16(m_db)));
         }
         close();
+        return;
+    }
+
+    if (options.busyTimeout > 0) {
+        sqlite3_busy_timeout(m_db, options.busyTimeout);
+    }
+
+    if (options.mmapSize > 0) {
+        execute(QStringLiteral("PRAGMA mmap_size = %1").arg(options.mmapSize));
+    }
+
+    // A negative value is in KiB rather than pages.
+    if (options.cacheSize > 0) {
+        execute(QStringLiteral("PRAGMA cache_size = -%1").arg(options.cacheSize));
     }
 }
 
@@ -125,6 +159,25 @@ bool Database::execute(const QString &sql)
     return true;
 }
 
+void Database::setInterruptFlag(const std::atomic_bool *flag)
+{
+    const QMutexLocker locker(&m_mutex);
+    if (m_db == nullptr) {
+        return;
+    }
+
+    if (flag == nullptr) {
+        sqlite3_progress_handler(m_db, 0, nullptr, nullptr);
+        return;
+    }
+
+    // The handler only reads the flag, which sqlite3 passes back as void *.
+    sqlite3_progress_handler(m_db,
+                             InterruptCheckInterval,
+                             interruptCallback,
+                             const_cast<void *>(static_cast<const void *>(flag)));
+}
+
 QString Database::lastError() const
 {
     // QString is not thread-safe for concurrent read+write.
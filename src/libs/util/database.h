@@ -8,6 +8,8 @@
 #include <QMutex>
 #include <QStringList>
 
+#include <atomic>
+
 struct sqlite3;
 
 namespace Zeal::Util {
@@ -16,7 +18,30 @@ class Database
 {
     Q_DISABLE_COPY_MOVE(Database)
 public:
-    explicit Database(const QString &path);
+    enum class OpenMode {
+        // Created if missing, with the default locking.
+        ReadWrite,
+        // Locks like ReadWrite, so other connections may still write.
+        ReadOnly,
+        // Skips locking and change detection altogether. The file must not be
+        // written to while open, by this or any other process.
+        Immutable
+    };
+
+    struct OpenOptions
+    {
+        OpenMode mode = OpenMode::ReadWrite;
+        // Bytes of the file read through a memory map instead of copies into
+        // the page cache, 0 to keep SQLite's default.
+        qint64 mmapSize = 0;
+        // Page cache size in KiB for this connection, 0 to keep SQLite's default.
+        int cacheSize = 0;
+        // Milliseconds to wait for another connection's lock before failing
+        // with SQLITE_BUSY, 0 to fail right away.
+        int busyTimeout = 0;
+    };
+
+    explicit Database(const QString &path, const OpenOptions &options = {});
     virtual ~Database();
 
     bool isOpen() const;
@@ -26,6 +51,11 @@ public:
 
     bool execute(const QString &sql);
 
+    // While *flag is set, statements running on this connection are aborted
+    // within a few hundred VM instructions and fail with SQLITE_INTERRUPT.
+    // The flag is polled, so it must outlive its use. Pass nullptr to clear.
+    void setInterruptFlag(const std::atomic_bool *flag);
+
     QString lastError() const;
 
     sqlite3 *handle() const;
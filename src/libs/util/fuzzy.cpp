@@ -2,13 +2,26 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include "fuzzy.h"
+#include "fuzzy_p.h"
 
 #include <algorithm>
 #include <array>
+#include <bit>
 #include <limits>
 #include <span>
 #include <vector>
 
+#if defined(__x86_64__) || defined(_M_X64)
+#define ZEAL_FUZZY_X86_SIMD
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define ZEAL_TARGET_AVX2
+#else
+#define ZEAL_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
 namespace Zeal::Util::Fuzzy {
 
 namespace {
@@ -22,7 +35,7 @@ constexpr double SCORE_MATCH_CAPITAL = 0.7;
 constexpr double SCORE_MATCH_DOT = 0.6;
 constexpr int FZY_MAX_LEN = 1024;
 
-void precomputeBonus(const QString &haystack, std::span<double> matchBonus)
+void precomputeBonus(QStringView haystack, std::span<double> matchBonus)
 {
     // Initialize to '/' so the first character of the haystack always receives
     // SCORE_MATCH_SLASH (0.9), the highest boundary bonus. This mirrors fzy's
@@ -50,41 +63,255 @@ void precomputeBonus(const QString &haystack, std::span<double> matchBonus)
     }
 }
 
-// Check if all characters in needle exist in haystack (in order, case-insensitive)
-// This is a pre-filter before running the expensive DP algorithm
-bool hasMatch(const QString &needle, const QString &haystack)
+// Subsequence scan kernels, see Detail::FindFunction.
+qsizetype findScalar(const char16_t *data, qsizetype from, qsizetype size, char16_t a, char16_t b, bool stopAtNonAscii)
 {
-    int haystackPos = 0;
-    const int haystackLen = static_cast<int>(haystack.length());
+    for (qsizetype i = from; i < size; ++i) {
+        const char16_t ch = data[i];
+        if (ch == a || ch == b || (stopAtNonAscii && ch > 0x7f)) {
+            return i;
+        }
+    }
+
+    return size;
+}
+
+#ifdef ZEAL_FUZZY_X86_SIMD
+qsizetype findSse2(const char16_t *data, qsizetype from, qsizetype size, char16_t a, char16_t b, bool stopAtNonAscii)
+{
+    const __m128i va = _mm_set1_epi16(static_cast<short>(a));
+    const __m128i vb = _mm_set1_epi16(static_cast<short>(b));
+    // Zero when non-ASCII units are not of interest, so that nothing is flagged.
+    const __m128i nonAsciiBits = _mm_set1_epi16(static_cast<short>(stopAtNonAscii ? 0xff80 : 0));
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(-1);
+
+    qsizetype i = from;
+    for (; i + 8 <= size; i += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        const __m128i isNonAscii = _mm_andnot_si128(_mm_cmpeq_epi16(_mm_and_si128(v, nonAsciiBits), zero), ones);
+        const __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi16(v, va), _mm_cmpeq_epi16(v, vb)), isNonAscii);
+
+        const auto mask = static_cast<unsigned>(_mm_movemask_epi8(hits));
+        if (mask != 0) {
+            return i + (std::countr_zero(mask) / 2);
+        }
+    }
+
+    return findScalar(data, i, size, a, b, stopAtNonAscii);
+}
+
+ZEAL_TARGET_AVX2
+qsizetype findAvx2(const char16_t *data, qsizetype from, qsizetype size, char16_t a, char16_t b, bool stopAtNonAscii)
+{
+    const __m256i va = _mm256_set1_epi16(static_cast<short>(a));
+    const __m256i vb = _mm256_set1_epi16(static_cast<short>(b));
+    const __m256i nonAsciiBits = _mm256_set1_epi16(static_cast<short>(stopAtNonAscii ? 0xff80 : 0));
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(-1);
+
+    qsizetype i = from;
+    for (; i + 16 <= size; i += 16) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        const __m256i isNonAscii
+            = _mm256_andnot_si256(_mm256_cmpeq_epi16(_mm256_and_si256(v, nonAsciiBits), zero), ones);
+        const __m256i hits
+            = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi16(v, va), _mm256_cmpeq_epi16(v, vb)), isNonAscii);
+
+        const auto mask = static_cast<unsigned>(_mm256_movemask_epi8(hits));
+        if (mask != 0) {
+            return i + (std::countr_zero(mask) / 2);
+        }
+    }
+
+    // The tail is shorter than a vector, finish it without leaving AVX2 code.
+    for (; i < size; ++i) {
+        const char16_t ch = data[i];
+        if (ch == a || ch == b || (stopAtNonAscii && ch > 0x7f)) {
+            return i;
+        }
+    }
+
+    return size;
+}
+
+bool isAvx2Supported()
+{
+#ifdef _MSC_VER
+    std::array<int, 4> info{};
+    __cpuid(info.data(), 0);
+    if (info[0] < 7) {
+        return false;
+    }
+
+    // The OS must save YMM state (OSXSAVE, then XCR0 bits 1 and 2).
+    __cpuid(info.data(), 1);
+    if ((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+
+    __cpuidex(info.data(), 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif // ZEAL_FUZZY_X86_SIMD
+
+// Score-only forward pass. Each cell depends only on the cell to its left and
+// on the upper-left one, so a single D row and a single M row are updated in
+// place, keeping the working set small. Performs the same operations in the
+// same order as the full-matrix pass in computeScore(), so scores are identical.
+double forwardScore(QStringView needle, std::span<const char16_t> hsLower, std::span<const double> matchBonus)
+{
+    const int needleLen = static_cast<int>(needle.length());
+    const int haystackLen = static_cast<int>(hsLower.size());
+
+    const double SCORE_MIN = -std::numeric_limits<double>::infinity();
+
+    static thread_local std::vector<double> rows;
+    if (rows.size() < 2 * static_cast<std::size_t>(haystackLen)) {
+        rows.resize(2 * static_cast<std::size_t>(haystackLen));
+    }
+    const auto D = std::span(rows).first(haystackLen);
+    const auto M = std::span(rows).subspan(haystackLen, haystackLen);
+
+    for (int i = 0; i < needleLen; ++i) {
+        double prevScore = SCORE_MIN;
+        const double gapScore = (i == needleLen - 1) ? SCORE_GAP_TRAILING : SCORE_GAP_INNER;
+
+        const char16_t needleCh = needle.at(i).toLower().unicode();
+
+        // D and M of row i - 1 at column j - 1, saved before being overwritten.
+        double prevD = SCORE_MIN;
+        double prevM = SCORE_MIN;
+
+        for (int j = 0; j < haystackLen; ++j) {
+            const double upperD = D[j];
+            const double upperM = M[j];
+
+            if (needleCh == hsLower[j]) {
+                double score = SCORE_MIN;
+
+                if (i == 0) {
+                    score = (j * SCORE_GAP_LEADING) + matchBonus[j];
+                } else if (j > 0) {
+                    score = std::max(prevM + matchBonus[j], prevD + SCORE_MATCH_CONSECUTIVE);
+                }
+
+                D[j] = score;
+                M[j] = prevScore = std::max(score, prevScore + gapScore);
+            } else {
+                D[j] = SCORE_MIN;
+                M[j] = prevScore = prevScore + gapScore;
+            }
+
+            prevD = upperD;
+            prevM = upperM;
+        }
+    }
+
+    return M[haystackLen - 1];
+}
+
+} // anonymous namespace
+
+namespace Detail {
+
+QList<Kernel> supportedKernels()
+{
+    QList<Kernel> kernels{{.name = "scalar", .find = &findScalar}};
+
+#ifdef ZEAL_FUZZY_X86_SIMD
+    // SSE2 is part of the x86-64 baseline.
+    kernels.append({.name = "sse2", .find = &findSse2});
 
-    for (int i = 0; i < needle.length(); ++i) {
-        const QChar needleCh = needle.at(i).toLower();
-        bool found = false;
+    if (isAvx2Supported()) {
+        kernels.append({.name = "avx2", .find = &findAvx2});
+    }
+#endif
+
+    return kernels;
+}
 
-        while (haystackPos < haystackLen) {
-            if (haystack.at(haystackPos).toLower() == needleCh) {
-                found = true;
-                ++haystackPos;
-                break;
+Kernel defaultKernel()
+{
+    static const Kernel kernel = supportedKernels().constLast();
+    return kernel;
+}
+
+bool hasMatch(FindFunction find, QStringView needle, QStringView haystack)
+{
+    const auto *data = reinterpret_cast<const char16_t *>(haystack.utf16());
+    const qsizetype size = haystack.size();
+    qsizetype pos = 0;
+
+    for (const QChar needleCh : needle) {
+        const char16_t lower = needleCh.toLower().unicode();
+
+        if (lower > 0x7f) {
+            // Rare: compare case-folded code units one by one.
+            while (pos < size && QChar(data[pos]).toLower().unicode() != lower) {
+                ++pos;
+            }
+        } else {
+            // An ASCII needle character matches itself, its ASCII upper case,
+            // and the odd non-ASCII unit that lowers to it (e.g. KELVIN SIGN).
+            const char16_t upper = (lower >= u'a' && lower <= u'z') ? lower - (u'a' - u'A') : lower;
+            for (;;) {
+                pos = find(data, pos, size, lower, upper, true);
+                if (pos == size || data[pos] <= 0x7f || QChar(data[pos]).toLower().unicode() == lower) {
+                    break;
+                }
+                ++pos;
             }
-            ++haystackPos;
         }
 
-        if (!found) {
+        if (pos == size) {
             return false;
         }
+
+        ++pos;
     }
 
     return true;
 }
 
-} // anonymous namespace
+bool hasLoweredMatch(FindFunction find, QStringView lowerNeedle, QStringView lowerHaystack)
+{
+    const auto *data = reinterpret_cast<const char16_t *>(lowerHaystack.utf16());
+    const qsizetype size = lowerHaystack.size();
+    qsizetype pos = 0;
+
+    for (const QChar needleCh : lowerNeedle) {
+        pos = find(data, pos, size, needleCh.unicode(), needleCh.unicode(), false);
+        if (pos == size) {
+            return false;
+        }
+
+        ++pos;
+    }
+
+    return true;
+}
+
+} // namespace Detail
 
 // ============================================================================
 // High-level Qt convenience API implementation
 // ============================================================================
 
-double score(const QString &needle, const QString &haystack, QList<int> *positions)
+bool hasMatch(QStringView needle, QStringView haystack)
+{
+    return Detail::hasMatch(Detail::defaultKernel().find, needle, haystack);
+}
+
+bool hasLoweredMatch(QStringView lowerNeedle, QStringView lowerHaystack)
+{
+    return Detail::hasLoweredMatch(Detail::defaultKernel().find, lowerNeedle, lowerHaystack);
+}
+
+double score(QStringView needle, QStringView haystack, QList<int> *positions)
 {
     // Pre-filter: check if all needle characters exist in haystack (performance optimization)
     // This avoids expensive DP computation on unmatchable strings
@@ -104,7 +331,7 @@ double score(const QString &needle, const QString &haystack, QList<int> *positio
 // Low-level API implementation
 // ============================================================================
 
-double computeScore(const QString &needle, const QString &haystack, QList<int> *positions)
+double computeScore(QStringView needle, QStringView haystack, QList<int> *positions)
 {
     const int needleLen = static_cast<int>(needle.length());
     const int haystackLen = static_cast<int>(haystack.length());
@@ -147,10 +374,25 @@ double computeScore(const QString &needle, const QString &haystack, QList<int> *
         return -std::numeric_limits<double>::infinity();
     }
 
-    std::array<double, FZY_MAX_LEN> matchBonusStorage{};
-    const std::span<double> matchBonus(matchBonusStorage);
+    // Only the first haystackLen entries are used, and they are always written
+    // first, so skip zeroing the whole buffer on every call.
+    static thread_local std::array<double, FZY_MAX_LEN> matchBonusStorage;
+    const auto matchBonus = std::span(matchBonusStorage).first(haystackLen);
     precomputeBonus(haystack, matchBonus);
 
+    // Lower the haystack once instead of once per needle row.
+    static thread_local std::array<char16_t, FZY_MAX_LEN> hsLowerStorage;
+    const auto hsLower = std::span(hsLowerStorage).first(haystackLen);
+    for (int j = 0; j < haystackLen; ++j) {
+        hsLower[j] = haystack.at(j).toLower().unicode();
+    }
+
+    // Most calls (e.g. from SQL) only need the score; the full matrices are
+    // only kept when positions have to be recovered by backtracking.
+    if (positions == nullptr) {
+        return forwardScore(needle, hsLower, matchBonus);
+    }
+
     const double SCORE_MIN = -std::numeric_limits<double>::infinity();
 
     // One flat buffer reused across calls on this thread; layout [D rows | M rows].
@@ -163,13 +405,6 @@ double computeScore(const QString &needle, const QString &haystack, QList<int> *
     const auto D = std::span(dp).first(cells);
     const auto M = std::span(dp).subspan(cells, cells);
 
-    // Lower the haystack once instead of once per needle row.
-    std::array<char16_t, FZY_MAX_LEN> hsLowerStorage{};
-    const std::span<char16_t> hsLower(hsLowerStorage);
-    for (int j = 0; j < haystackLen; ++j) {
-        hsLower[j] = haystack.at(j).toLower().unicode();
-    }
-
     auto idx = [haystackLen](int i, int j) {
         return (i * haystackLen) + j;
     };
@@ -204,9 +439,9 @@ double computeScore(const QString &needle, const QString &haystack, QList<int> *
 
     const double result = M[idx(needleLen - 1, haystackLen - 1)];
 
-    // Backtrack to find positions if requested (fzy algorithm)
+    // Backtrack to find positions (fzy algorithm)
     // Only backtrack if we have a valid match (not SCORE_MIN)
-    if (positions != nullptr && result != SCORE_MIN) {
+    if (result != SCORE_MIN) {
         positions->resize(needleLen);
         bool matchRequired = false;
 
@@ -230,6 +465,26 @@ double computeScore(const QString &needle, const QString &haystack, QList<int> *
     return result;
 }
 
+double maxScore(qsizetype needleLength, qsizetype haystackLength)
+{
+    if (needleLength == 0 || needleLength > haystackLength || haystackLength > FZY_MAX_LEN) {
+        return -std::numeric_limits<double>::infinity();
+    }
+
+    if (needleLength == haystackLength) {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    constexpr double MaxBonus = std::max({SCORE_MATCH_SLASH, SCORE_MATCH_WORD, SCORE_MATCH_CAPITAL, SCORE_MATCH_DOT});
+    constexpr double MaxMatch = std::max(MaxBonus, SCORE_MATCH_CONSECUTIVE);
+    constexpr double MinGapPenalty = std::max({SCORE_GAP_LEADING, SCORE_GAP_TRAILING, SCORE_GAP_INNER});
+    // Well above the rounding error of summing up to FZY_MAX_LEN terms.
+    constexpr double Slack = 1e-9;
+
+    const auto gaps = static_cast<double>(haystackLength - needleLength);
+    return MaxBonus + (static_cast<double>(needleLength - 1) * MaxMatch) + (gaps * MinGapPenalty) + Slack;
+}
+
 double scoreFunction(const QString &needle, const QString &haystack)
 {
     return score(needle, haystack, nullptr);
@@ -241,4 +496,32 @@ double scoreFunction(const char *needle, const char *haystack)
     return scoreFunction(QString::fromUtf8(needle), QString::fromUtf8(haystack));
 }
 
+double scoreUtf8(QStringView lowerNeedle, const char *haystack, qsizetype size)
+{
+    // UTF-8 never takes fewer bytes than UTF-16 code units.
+    if (lowerNeedle.isEmpty() || size < lowerNeedle.size()) {
+        return -std::numeric_limits<double>::infinity();
+    }
+
+    // Longer non-ASCII text may still decode to few enough code units to be
+    // scored, so it is left to the slow path below.
+    if (size <= FZY_MAX_LEN) {
+        // Widen while checking for non-ASCII bytes, which is cheaper than a
+        // separate scan since nearly all symbol names are ASCII.
+        static thread_local std::array<char16_t, FZY_MAX_LEN> buffer;
+        const auto *bytes = reinterpret_cast<const unsigned char *>(haystack);
+        unsigned char seen = 0;
+        for (qsizetype i = 0; i < size; ++i) {
+            seen |= bytes[i];
+            buffer[i] = bytes[i];
+        }
+
+        if ((seen & 0x80) == 0) {
+            return score(lowerNeedle, QStringView(buffer.data(), size), nullptr);
+        }
+    }
+
+    return score(lowerNeedle, QString::fromUtf8(haystack, size), nullptr);
+}
+
 } // namespace Zeal::Util::Fuzzy
@@ -6,13 +6,39 @@
 
 #include <QList>
 #include <QString>
+#include <QStringView>
 
 namespace Zeal::Util::Fuzzy {
 
 // Fuzzy matching is based on https://github.com/jhawthorn/fzy by John Hawthorn, MIT License.
 
 /**
- * @brief Computes fuzzy match score for QString inputs, optionally returning match positions
+ * @brief Checks whether needle is a case-insensitive subsequence of haystack
+ *
+ * Cheap pre-filter for score(): a haystack that fails it can only score -infinity.
+ * Case folding is per UTF-16 code unit, as in computeScore(). Uses SIMD kernels
+ * chosen at runtime where available.
+ *
+ * @param needle Search query
+ * @param haystack Text to search in
+ * @return true if every needle character occurs in haystack in order
+ */
+bool hasMatch(QStringView needle, QStringView haystack);
+
+/**
+ * @brief hasMatch() for inputs already lowercased per UTF-16 code unit
+ *
+ * Skips case folding entirely, which makes it the fast path for callers that
+ * keep a lowercased copy of their haystacks, such as an in-memory symbol index.
+ *
+ * @param lowerNeedle Search query, lowercased with QChar::toLower() per code unit
+ * @param lowerHaystack Text to search in, lowercased the same way
+ * @return true if every needle character occurs in haystack in order
+ */
+bool hasLoweredMatch(QStringView lowerNeedle, QStringView lowerHaystack);
+
+/**
+ * @brief Computes fuzzy match score for string inputs, optionally returning match positions
  *
  * Convenience wrapper around computeScore() with pre-filtering for performance.
  * Returns raw fzy scores - caller should filter results (e.g., WHERE score > 0 in SQL).
@@ -28,7 +54,7 @@ namespace Zeal::Util::Fuzzy {
  * @param positions Optional output list of matched haystack indices for highlighting
  * @return Match score (higher is better, -infinity for no match)
  */
-double score(const QString &needle, const QString &haystack, QList<int> *positions = nullptr);
+double score(QStringView needle, QStringView haystack, QList<int> *positions = nullptr);
 
 /**
  * @brief Computes fuzzy match score, optionally returning match positions
@@ -44,7 +70,24 @@ double score(const QString &needle, const QString &haystack, QList<int> *positio
  * @return Fuzzy match score (-infinity if no match possible, infinity if needle == haystack,
  *         otherwise unbounded: ~0.9 + (n-1) for a perfect length-n consecutive match)
  */
-double computeScore(const QString &needle, const QString &haystack, QList<int> *positions = nullptr);
+double computeScore(QStringView needle, QStringView haystack, QList<int> *positions = nullptr);
+
+/**
+ * @brief Upper bound of computeScore() from string lengths alone
+ *
+ * Assumes the best case for every character: the highest boundary bonus for
+ * the first match, consecutive bonuses for the rest, and the cheapest gap
+ * penalty for each unmatched haystack character. Callers that keep only the
+ * best results can skip scoring a haystack whose bound does not exceed the
+ * worst score they still keep. The bound is slightly inflated, so that
+ * rounding in the actual computation never makes it too tight.
+ *
+ * @param needleLength Length of the needle in UTF-16 code units
+ * @param haystackLength Length of the haystack in UTF-16 code units
+ * @return Highest possible score (infinity for equal lengths, -infinity if
+ *         computeScore() cannot match at all)
+ */
+double maxScore(qsizetype needleLength, qsizetype haystackLength);
 
 /**
  * @brief Main scoring function for use in SQLite callbacks
@@ -76,6 +119,21 @@ double scoreFunction(const QString &needle, const QString &haystack);
  */
 double scoreFunction(const char *needle, const char *haystack);
 
+/**
+ * @brief Scores UTF-8 text against a needle lowered ahead of time
+ *
+ * Per-row entry point for SQLite callbacks, which get the haystack as UTF-8
+ * bytes and can lower the needle once per statement. ASCII haystacks are
+ * widened into a per-thread buffer without allocating, anything else is
+ * decoded with QString::fromUtf8(). Scores are identical to score().
+ *
+ * @param lowerNeedle Search query, lowercased with QChar::toLower() per code unit
+ * @param haystack Text to search in (UTF-8, not necessarily null-terminated)
+ * @param size Length of haystack in bytes
+ * @return Match score (higher is better, -infinity for no match)
+ */
+double scoreUtf8(QStringView lowerNeedle, const char *haystack, qsizetype size);
+
 } // namespace Zeal::Util::Fuzzy
 
 #endif // ZEAL_UTIL_FUZZY_H
@@ -0,0 +1,36 @@
+// Copyright (C) Oleg Shparber, et al. <https://zealdocs.org>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef ZEAL_UTIL_FUZZY_P_H
+#define ZEAL_UTIL_FUZZY_P_H
+
+// Subsequence pre-filter kernels of fuzzy.cpp, exposed for tests and benchmarks.
+
+#include <QList>
+#include <QStringView>
+
+namespace Zeal::Util::Fuzzy::Detail {
+
+// Returns the index of the first code unit in [from, size) that equals a or b,
+// or, if stopAtNonAscii is set, is above U+007F. Returns size if there is none.
+using FindFunction = qsizetype (*)(const char16_t *data, qsizetype from, qsizetype size,
+                                   char16_t a, char16_t b, bool stopAtNonAscii);
+
+struct Kernel
+{
+    const char *name = nullptr;
+    FindFunction find = nullptr;
+};
+
+// Kernels supported by the running CPU, scalar first and fastest last.
+QList<Kernel> supportedKernels();
+
+// Kernel chosen at runtime for hasMatch() and hasLoweredMatch().
+Kernel defaultKernel();
+
+bool hasMatch(FindFunction find, QStringView needle, QStringView haystack);
+bool hasLoweredMatch(FindFunction find, QStringView lowerNeedle, QStringView lowerHaystack);
+
+} // namespace Zeal::Util::Fuzzy::Detail
+
+#endif // ZEAL_UTIL_FUZZY_P_H
@@ -0,0 +1,128 @@
+// Copyright (C) Oleg Shparber, et al. <https://zealdocs.org>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "../database.h"
+#include "../statement.h"
+
+#include <QtTest>
+
+#include <memory>
+
+using namespace Zeal::Util;
+
+Q_DECLARE_METATYPE(Zeal::Util::Database::OpenOptions)
+
+// Compares the open modes of Database on a docset-sized symbol table, for a
+// full LIKE scan and for many short indexed lookups, where per-statement
+// locking matters most.
+// Not part of the test suite; run database_benchmark directly. The file is
+// written by initTestCase(), so every row reads it from the OS cache.
+class DatabaseBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void benchmarkScan_data();
+    void benchmarkScan();
+    void benchmarkLookup_data();
+    void benchmarkLookup();
+
+private:
+    static void addModeRows();
+
+    std::unique_ptr<QTemporaryDir> m_dir;
+    QString m_path;
+};
+
+void DatabaseBenchmark::initTestCase()
+{
+    m_dir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_dir->isValid());
+
+    m_path = m_dir->filePath(QStringLiteral("docSet.dsidx"));
+
+    // A synthetic index of 500k symbols, with the name index Zeal creates.
+    Database db(m_path);
+    QVERIFY(db.execute(QStringLiteral("CREATE TABLE searchIndex (id INTEGER PRIMARY KEY, name TEXT, type TEXT, path TEXT)")));
+    QVERIFY(db.execute(QStringLiteral("WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < 500000)"
+                                      "  INSERT INTO searchIndex (name, type, path)"
+                                      "  SELECT 'Symbol' || i || '::member' || (i % 97), 'Method', 'page' || (i / 100) || '.html'"
+                                      "  FROM n")));
+    QVERIFY(db.execute(QStringLiteral("CREATE INDEX __zi_name0001 ON searchIndex (name COLLATE NOCASE)")));
+}
+
+void DatabaseBenchmark::benchmarkScan_data()
+{
+    addModeRows();
+}
+
+void DatabaseBenchmark::benchmarkScan()
+{
+    QFETCH(Database::OpenOptions, options);
+
+    Database db(m_path, options);
+    QVERIFY(db.isOpen());
+
+    int count = 0;
+    QBENCHMARK {
+        Statement stmt(db,
+                       QStringLiteral("SELECT name, type, path, -length(name) AS score"
+                                      "  FROM searchIndex"
+                                      "  WHERE name LIKE '%member42%'"
+                                      "  ORDER BY score DESC"
+                                      "  LIMIT 100"));
+        count = 0;
+        while (stmt.step()) {
+            ++count;
+        }
+    }
+
+    QCOMPARE(count, 100);
+}
+
+void DatabaseBenchmark::benchmarkLookup_data()
+{
+    addModeRows();
+}
+
+void DatabaseBenchmark::benchmarkLookup()
+{
+    QFETCH(Database::OpenOptions, options);
+
+    Database db(m_path, options);
+    QVERIFY(db.isOpen());
+
+    // Each statement takes and releases a shared lock, unless immutable.
+    int found = 0;
+    QBENCHMARK {
+        found = 0;
+        for (int i = 1; i <= 1000; ++i) {
+            Statement stmt(db, QStringLiteral("SELECT path FROM searchIndex WHERE name = ? COLLATE NOCASE"));
+            stmt.bindText(1, QStringLiteral("symbol%1::member%2").arg(i * 499).arg(i * 499 % 97));
+            found += stmt.step() ? 1 : 0;
+        }
+    }
+
+    QCOMPARE(found, 1000);
+}
+
+void DatabaseBenchmark::addModeRows()
+{
+    QTest::addColumn<Database::OpenOptions>("options");
+
+    using OpenMode = Database::OpenMode;
+    constexpr qint64 MmapSize = 256 * 1024 * 1024;
+
+    QTest::newRow("read-write") << Database::OpenOptions{};
+    QTest::newRow("read-only") << Database::OpenOptions{.mode = OpenMode::ReadOnly};
+    QTest::newRow("read-only mmap") << Database::OpenOptions{.mode = OpenMode::ReadOnly, .mmapSize = MmapSize};
+    QTest::newRow("immutable") << Database::OpenOptions{.mode = OpenMode::Immutable};
+    QTest::newRow("immutable mmap") << Database::OpenOptions{.mode = OpenMode::Immutable, .mmapSize = MmapSize};
+    QTest::newRow("immutable mmap 8 MiB cache")
+        << Database::OpenOptions{.mode = OpenMode::Immutable, .mmapSize = MmapSize, .cacheSize = 8 * 1024};
+}
+
+QTEST_MAIN(DatabaseBenchmark)
+#include "database_benchmark.moc"
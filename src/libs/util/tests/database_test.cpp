@@ -0,0 +1,219 @@
+// Copyright (C) Oleg Shparber, et al. <https://zealdocs.org>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "../database.h"
+#include "../statement.h"
+
+#include <QtTest>
+
+#include <sqlite3.h>
+
+#include <atomic>
+#include <memory>
+
+using namespace Zeal::Util;
+
+class DatabaseTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void testUnsetFlagDoesNotInterrupt();
+    void testSetFlagInterrupts();
+    void testClearedFlagIsIgnored();
+    void testSetFlagInterruptsRunningQuery();
+
+    void testReadOnlyModeRejectsWrites();
+    void testImmutableModeReads();
+    void testReadOnlyModeDoesNotCreateFile();
+    void testBusyTimeoutWaitsForLock();
+
+private:
+    // Symbols x symbols substring join, far too slow to finish during the test.
+    static constexpr auto SlowQuery = "SELECT count(*) FROM searchIndex a, searchIndex b"
+                                      "  WHERE a.name LIKE '%' || b.name || '%'";
+
+    std::unique_ptr<Database> m_db;
+};
+
+void DatabaseTest::initTestCase()
+{
+    m_db = std::make_unique<Database>(QStringLiteral(":memory:"));
+    QVERIFY(m_db->isOpen());
+
+    // A synthetic index of 50k symbols.
+    QVERIFY(m_db->execute(QStringLiteral("CREATE TABLE searchIndex (name TEXT, type TEXT, path TEXT)")));
+    QVERIFY(m_db->execute(QStringLiteral("WITH RECURSIVE n(i) AS"
+                                         "  (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < 50000)"
+                                         "  INSERT INTO searchIndex"
+                                         "  SELECT 'Symbol' || i || '::member' || (i % 97), 'Method',"
+                                         "  'page' || (i / 100) || '.html'"
+                                         "  FROM n")));
+}
+
+void DatabaseTest::testUnsetFlagDoesNotInterrupt()
+{
+    const std::atomic_bool canceled{false};
+    m_db->setInterruptFlag(&canceled);
+
+    Statement stmt(*m_db, QStringLiteral("SELECT count(*) FROM searchIndex WHERE name LIKE '%member1%'"));
+    QVERIFY(stmt.step());
+    QVERIFY(stmt.value(0).toInt() > 0);
+    QVERIFY(stmt.lastError().isEmpty());
+
+    m_db->setInterruptFlag(nullptr);
+}
+
+void DatabaseTest::testSetFlagInterrupts()
+{
+    const std::atomic_bool canceled{true};
+    m_db->setInterruptFlag(&canceled);
+
+    Statement stmt(*m_db, QString::fromLatin1(SlowQuery));
+    QVERIFY(!stmt.step());
+    QVERIFY(!stmt.lastError().isEmpty());
+
+    m_db->setInterruptFlag(nullptr);
+}
+
+void DatabaseTest::testClearedFlagIsIgnored()
+{
+    const std::atomic_bool canceled{true};
+    m_db->setInterruptFlag(&canceled);
+    m_db->setInterruptFlag(nullptr);
+
+    Statement stmt(*m_db, QStringLiteral("SELECT count(*) FROM searchIndex"));
+    QVERIFY(stmt.step());
+    QCOMPARE(stmt.value(0).toInt(), 50000);
+}
+
+void DatabaseTest::testSetFlagInterruptsRunningQuery()
+{
+    std::atomic_bool canceled{false};
+    m_db->setInterruptFlag(&canceled);
+
+    int rowCount = 0;
+    int errorCode = SQLITE_OK;
+    std::unique_ptr<QThread> thread(QThread::create([this, &rowCount, &errorCode]() {
+        Statement stmt(*m_db, QString::fromLatin1(SlowQuery));
+        while (stmt.step()) {
+            ++rowCount;
+        }
+        errorCode = sqlite3_errcode(m_db->handle());
+    }));
+    thread->start();
+
+    // Let the query get well into the join before canceling it.
+    QVERIFY(!thread->wait(200));
+
+    // The progress handler polls the flag every few hundred instructions, so
+    // the query stops well before anyone typing would notice.
+    QElapsedTimer timer;
+    timer.start();
+    canceled.store(true, std::memory_order_relaxed);
+    QVERIFY(thread->wait(5000));
+    const qint64 latency = timer.elapsed();
+
+    m_db->setInterruptFlag(nullptr);
+
+    QVERIFY2(latency < 500, qPrintable(QStringLiteral("Interrupt took %1 ms.").arg(latency)));
+
+    // Aborted before the aggregate could produce its row.
+    QCOMPARE(errorCode, SQLITE_INTERRUPT);
+    QCOMPARE(rowCount, 0);
+}
+
+void DatabaseTest::testReadOnlyModeRejectsWrites()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    const QString path = dir.filePath(QStringLiteral("docSet.dsidx"));
+    {
+        Database db(path);
+        QVERIFY(db.execute(QStringLiteral("CREATE TABLE searchIndex (name TEXT)")));
+    }
+
+    Database db(path, {.mode = Database::OpenMode::ReadOnly, .mmapSize = 1024 * 1024, .cacheSize = 1024});
+    QVERIFY(db.isOpen());
+    QCOMPARE(db.tables(), QStringList({QStringLiteral("searchIndex")}));
+    QVERIFY(!db.execute(QStringLiteral("INSERT INTO searchIndex VALUES ('QString')")));
+
+    Statement stmt(db, QStringLiteral("PRAGMA cache_size"));
+    QVERIFY(stmt.step());
+    QCOMPARE(stmt.value(0).toInt(), -1024);
+}
+
+void DatabaseTest::testImmutableModeReads()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    // Characters that have a meaning in URIs are escaped.
+    const QString path = dir.filePath(QStringLiteral("C++ #1?.dsidx"));
+    {
+        Database db(path);
+        QVERIFY(db.execute(QStringLiteral("CREATE TABLE searchIndex (name TEXT)")));
+        QVERIFY(db.execute(QStringLiteral("INSERT INTO searchIndex VALUES ('QString'), ('QStringList')")));
+    }
+
+    Database db(path, {.mode = Database::OpenMode::Immutable});
+    QVERIFY(db.isOpen());
+
+    Statement stmt(db, QStringLiteral("SELECT count(*) FROM searchIndex"));
+    QVERIFY(stmt.step());
+    QCOMPARE(stmt.value(0).toInt(), 2);
+}
+
+void DatabaseTest::testReadOnlyModeDoesNotCreateFile()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    const QString path = dir.filePath(QStringLiteral("missing.dsidx"));
+    const Database db(path, {.mode = Database::OpenMode::ReadOnly});
+    QVERIFY(!db.isOpen());
+    QVERIFY(!db.lastError().isEmpty());
+    QVERIFY(!QFile::exists(path));
+}
+
+void DatabaseTest::testBusyTimeoutWaitsForLock()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    const QString path = dir.filePath(QStringLiteral("docSet.dsidx"));
+    Database writer(path);
+    QVERIFY(writer.execute(QStringLiteral("CREATE TABLE searchIndex (name TEXT)")));
+    QVERIFY(writer.execute(QStringLiteral("INSERT INTO searchIndex VALUES ('QString')")));
+
+    // Like an index build committing while a docset is searched.
+    QVERIFY(writer.execute(QStringLiteral("BEGIN EXCLUSIVE")));
+
+    {
+        Database reader(path, {.mode = Database::OpenMode::ReadOnly});
+        Statement stmt(reader, QStringLiteral("SELECT count(*) FROM searchIndex"));
+        QVERIFY(!stmt.step());
+        QVERIFY(!stmt.lastError().isEmpty());
+    }
+
+    Database reader(path, {.mode = Database::OpenMode::ReadOnly, .busyTimeout = 5000});
+
+    int count = 0;
+    std::unique_ptr<QThread> thread(QThread::create([&reader, &count]() {
+        Statement stmt(reader, QStringLiteral("SELECT count(*) FROM searchIndex"));
+        count = stmt.step() ? stmt.value(0).toInt() : -1;
+    }));
+    thread->start();
+
+    QVERIFY(!thread->wait(100));
+    QVERIFY(writer.execute(QStringLiteral("COMMIT")));
+    QVERIFY(thread->wait(5000));
+    QCOMPARE(count, 1);
+}
+
+QTEST_MAIN(DatabaseTest)
+
+#include "database_test.moc"
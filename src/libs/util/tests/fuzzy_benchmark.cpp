@@ -0,0 +1,343 @@
+// Copyright (C) Oleg Shparber, et al. <https://zealdocs.org>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "../fuzzy.h"
+#include "../fuzzy_p.h"
+
+#include <QHash>
+#include <QRandomGenerator>
+#include <QtTest>
+
+using namespace Zeal::Util::Fuzzy;
+
+// Measures the subsequence pre-filter with every kernel the CPU supports, and
+// the scorer on corpora shaped like real symbol names.
+// Not part of the test suite; run fuzzy_benchmark directly, e.g. with -tickcounter.
+// Scorer rows also log ns/candidate and candidates/s, which end up in the
+// machine-readable reports, e.g. -o results.xml,xml.
+class FuzzyBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void benchmarkHasMatch_data();
+    void benchmarkHasMatch();
+    void benchmarkHasLoweredMatch_data();
+    void benchmarkHasLoweredMatch();
+
+    void benchmarkScore_data();
+    void benchmarkScore();
+    void benchmarkScoreUtf8_data();
+    void benchmarkScoreUtf8();
+
+private:
+    static void addKernelRows();
+    static QStringList generateCorpus(const QStringList &parts,
+                                      const QStringList &separators,
+                                      int count,
+                                      int minLength,
+                                      int maxLength);
+
+    QStringList m_haystacks;
+    QStringList m_lowerHaystacks;
+
+    // Scorer corpora by name, each with a needle that matches a good share.
+    QHash<QString, QStringList> m_corpora;
+    QHash<QString, QString> m_corpusNeedles;
+};
+
+void FuzzyBenchmark::initTestCase()
+{
+    // Symbol-like names: identifiers joined by scope separators, 8-80 characters.
+    static const QStringList parts = {
+        QStringLiteral("QAbstractItemModel"), QStringLiteral("begin"),    QStringLiteral("Insert"),
+        QStringLiteral("rows"),               QStringLiteral("std"),      QStringLiteral("vector"),
+        QStringLiteral("emplace_back"),       QStringLiteral("Array"),    QStringLiteral("prototype"),
+        QStringLiteral("forEach"),            QStringLiteral("django"),   QStringLiteral("HttpResponse"),
+        QStringLiteral("Übersicht"),          QStringLiteral("set_value"), QStringLiteral("__init__"),
+    };
+    static const QStringList separators
+        = {QStringLiteral("::"), QStringLiteral("."), QStringLiteral("_"), QStringLiteral("/"), QString()};
+
+    QRandomGenerator generator(42);
+    for (int i = 0; i < 100000; ++i) {
+        QString name = parts.at(generator.bounded(parts.size()));
+        const int count = generator.bounded(1, 5);
+        for (int j = 0; j < count; ++j) {
+            name += separators.at(generator.bounded(separators.size()));
+            name += parts.at(generator.bounded(parts.size()));
+        }
+
+        QString lowerName;
+        for (const QChar ch : std::as_const(name)) {
+            lowerName.append(ch.toLower());
+        }
+
+        m_haystacks.append(name);
+        m_lowerHaystacks.append(lowerName);
+    }
+
+    const QStringList words = {QStringLiteral("get"),
+                               QStringLiteral("value"),
+                               QStringLiteral("string"),
+                               QStringLiteral("list"),
+                               QStringLiteral("insert"),
+                               QStringLiteral("rows"),
+                               QStringLiteral("model"),
+                               QStringLiteral("index")};
+    const QStringList camelWords = {QStringLiteral("Abstract"),
+                                    QStringLiteral("Item"),
+                                    QStringLiteral("Model"),
+                                    QStringLiteral("begin"),
+                                    QStringLiteral("Insert"),
+                                    QStringLiteral("Rows"),
+                                    QStringLiteral("Get"),
+                                    QStringLiteral("Value")};
+    const QStringList namespaces = {QStringLiteral("std"),
+                                    QStringLiteral("chrono"),
+                                    QStringLiteral("ranges"),
+                                    QStringLiteral("views"),
+                                    QStringLiteral("filesystem"),
+                                    QStringLiteral("path"),
+                                    QStringLiteral("duration_cast"),
+                                    QStringLiteral("transform")};
+    const QStringList unicodeWords = {QStringLiteral("Übersicht"),
+                                      QStringLiteral("größe"),
+                                      QStringLiteral("значение"),
+                                      QStringLiteral("список"),
+                                      QStringLiteral("関数"),
+                                      QStringLiteral("値"),
+                                      QStringLiteral("get"),
+                                      QStringLiteral("Wert")};
+
+    const QString empty;
+    const QString dot = QStringLiteral(".");
+    const QString scope = QStringLiteral("::");
+    const QString underscore = QStringLiteral("_");
+
+    m_corpora.insert(QStringLiteral("short"), generateCorpus(words, {empty, underscore}, 10000, 3, 12));
+    m_corpora.insert(QStringLiteral("long"), generateCorpus(words, {dot, underscore}, 10000, 40, 200));
+    m_corpora.insert(QStringLiteral("camelcase"), generateCorpus(camelWords, {empty}, 10000, 8, 48));
+    m_corpora.insert(QStringLiteral("namespaced"), generateCorpus(namespaces, {scope}, 10000, 10, 80));
+    m_corpora.insert(QStringLiteral("unicode"), generateCorpus(unicodeWords, {dot, underscore}, 10000, 6, 60));
+    // Longer than the scorer's matrix, so these take the fallback path.
+    m_corpora.insert(QStringLiteral("oversized"), generateCorpus(words, {dot, scope}, 500, 1100, 2000));
+
+    m_corpusNeedles.insert(QStringLiteral("short"), QStringLiteral("gval"));
+    m_corpusNeedles.insert(QStringLiteral("long"), QStringLiteral("strins"));
+    m_corpusNeedles.insert(QStringLiteral("camelcase"), QStringLiteral("aim"));
+    m_corpusNeedles.insert(QStringLiteral("namespaced"), QStringLiteral("std::dur"));
+    m_corpusNeedles.insert(QStringLiteral("unicode"), QStringLiteral("знач"));
+    m_corpusNeedles.insert(QStringLiteral("oversized"), QStringLiteral("modidx"));
+}
+
+QStringList FuzzyBenchmark::generateCorpus(const QStringList &parts,
+                                           const QStringList &separators,
+                                           int count,
+                                           int minLength,
+                                           int maxLength)
+{
+    QRandomGenerator generator(42);
+
+    QStringList corpus;
+    corpus.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const int length = generator.bounded(minLength, maxLength + 1);
+
+        QString name = parts.at(generator.bounded(parts.size()));
+        while (name.size() < length) {
+            name += separators.at(generator.bounded(separators.size()));
+            name += parts.at(generator.bounded(parts.size()));
+        }
+
+        corpus.append(name.left(length));
+    }
+
+    return corpus;
+}
+
+void FuzzyBenchmark::addKernelRows()
+{
+    QTest::addColumn<QString>("needle");
+    QTest::addColumn<int>("kernel");
+
+    static const QStringList needles = {QStringLiteral("qs"), QStringLiteral("insrow"), QStringLiteral("zzz")};
+
+    const QList<Detail::Kernel> kernels = Detail::supportedKernels();
+    for (const QString &needle : needles) {
+        for (int i = 0; i < kernels.size(); ++i) {
+            QTest::addRow("%s/%s", qPrintable(needle), kernels.at(i).name) << needle << i;
+        }
+    }
+}
+
+void FuzzyBenchmark::benchmarkHasMatch_data()
+{
+    addKernelRows();
+}
+
+void FuzzyBenchmark::benchmarkHasMatch()
+{
+    QFETCH(QString, needle);
+    QFETCH(int, kernel);
+
+    const Detail::FindFunction find = Detail::supportedKernels().at(kernel).find;
+
+    int matches = 0;
+    QBENCHMARK {
+        matches = 0;
+        for (const QString &haystack : std::as_const(m_haystacks)) {
+            matches += Detail::hasMatch(find, needle, haystack) ? 1 : 0;
+        }
+    }
+
+    QVERIFY(matches <= m_haystacks.size());
+}
+
+void FuzzyBenchmark::benchmarkHasLoweredMatch_data()
+{
+    addKernelRows();
+}
+
+void FuzzyBenchmark::benchmarkHasLoweredMatch()
+{
+    QFETCH(QString, needle);
+    QFETCH(int, kernel);
+
+    const Detail::FindFunction find = Detail::supportedKernels().at(kernel).find;
+
+    int matches = 0;
+    QBENCHMARK {
+        matches = 0;
+        for (const QString &haystack : std::as_const(m_lowerHaystacks)) {
+            matches += Detail::hasLoweredMatch(find, needle, haystack) ? 1 : 0;
+        }
+    }
+
+    QVERIFY(matches <= m_lowerHaystacks.size());
+}
+
+void FuzzyBenchmark::benchmarkScore_data()
+{
+    QTest::addColumn<QString>("corpus");
+    QTest::addColumn<bool>("isPrefiltered");
+    QTest::addColumn<bool>("hasPositions");
+
+    static const QStringList corpora = {QStringLiteral("short"),
+                                        QStringLiteral("long"),
+                                        QStringLiteral("camelcase"),
+                                        QStringLiteral("namespaced"),
+                                        QStringLiteral("unicode"),
+                                        QStringLiteral("oversized")};
+
+    for (const QString &corpus : corpora) {
+        for (const bool hasPositions : {false, true}) {
+            const char *positions = hasPositions ? "positions" : "score-only";
+            QTest::addRow("%s/score/%s", qPrintable(corpus), positions) << corpus << true << hasPositions;
+            QTest::addRow("%s/computeScore/%s", qPrintable(corpus), positions) << corpus << false << hasPositions;
+        }
+    }
+}
+
+void FuzzyBenchmark::benchmarkScore()
+{
+    QFETCH(QString, corpus);
+    QFETCH(bool, isPrefiltered);
+    QFETCH(bool, hasPositions);
+
+    const QStringList haystacks = m_corpora.value(corpus);
+    const QString needle = m_corpusNeedles.value(corpus);
+    QVERIFY(!haystacks.isEmpty());
+
+    QList<int> positions;
+    QList<int> *positionsOut = hasPositions ? &positions : nullptr;
+
+    qint64 elapsed = 0;
+    qint64 candidates = 0;
+    int matches = 0;
+
+    QBENCHMARK {
+        QElapsedTimer timer;
+        timer.start();
+
+        matches = 0;
+        for (const QString &haystack : haystacks) {
+            const double s = isPrefiltered ? score(needle, haystack, positionsOut)
+                                           : computeScore(needle, haystack, positionsOut);
+            matches += s > 0 ? 1 : 0;
+        }
+
+        elapsed += timer.nsecsElapsed();
+        candidates += haystacks.size();
+    }
+
+    const double nsPerCandidate = static_cast<double>(elapsed) / static_cast<double>(candidates);
+    qInfo("%.1f ns/candidate, %.0f candidates/s, %d of %d matched",
+          nsPerCandidate,
+          1e9 / nsPerCandidate,
+          matches,
+          static_cast<int>(haystacks.size()));
+}
+
+// The SQLite callback path: UTF-8 haystacks, with the needle decoded and
+// lowered per row (legacy) or once per statement (UTF-8).
+void FuzzyBenchmark::benchmarkScoreUtf8_data()
+{
+    QTest::addColumn<QString>("corpus");
+    QTest::addColumn<bool>("isUtf8");
+
+    for (const QString &corpus : {QStringLiteral("short"), QStringLiteral("namespaced"), QStringLiteral("unicode")}) {
+        QTest::addRow("%s/legacy", qPrintable(corpus)) << corpus << false;
+        QTest::addRow("%s/utf8", qPrintable(corpus)) << corpus << true;
+    }
+}
+
+void FuzzyBenchmark::benchmarkScoreUtf8()
+{
+    QFETCH(QString, corpus);
+    QFETCH(bool, isUtf8);
+
+    QList<QByteArray> haystacks;
+    for (const QString &haystack : m_corpora.value(corpus)) {
+        haystacks.append(haystack.toUtf8());
+    }
+    QVERIFY(!haystacks.isEmpty());
+
+    const QString needle = m_corpusNeedles.value(corpus);
+    const QByteArray utf8Needle = needle.toUtf8();
+    QString lowerNeedle;
+    for (const QChar ch : needle) {
+        lowerNeedle.append(ch.toLower());
+    }
+
+    qint64 elapsed = 0;
+    qint64 candidates = 0;
+    int matches = 0;
+
+    QBENCHMARK {
+        QElapsedTimer timer;
+        timer.start();
+
+        matches = 0;
+        for (const QByteArray &haystack : std::as_const(haystacks)) {
+            const double s = isUtf8 ? scoreUtf8(lowerNeedle, haystack.constData(), haystack.size())
+                                    : scoreFunction(utf8Needle.constData(), haystack.constData());
+            matches += s > 0 ? 1 : 0;
+        }
+
+        elapsed += timer.nsecsElapsed();
+        candidates += haystacks.size();
+    }
+
+    const double nsPerCandidate = static_cast<double>(elapsed) / static_cast<double>(candidates);
+    qInfo("%.1f ns/candidate, %.0f candidates/s, %d of %d matched",
+          nsPerCandidate,
+          1e9 / nsPerCandidate,
+          matches,
+          static_cast<int>(haystacks.size()));
+}
+
+QTEST_MAIN(FuzzyBenchmark)
+#include "fuzzy_benchmark.moc"
@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include "../fuzzy.h"
+#include "../fuzzy_p.h"
 
 #include <QtTest>
 
@@ -59,6 +60,24 @@ private slots:
     // Backtracking regression tests
     void testBacktrackingPrefixConflict();
     void testBacktrackingWordBoundaryWins();
+
+    // Subsequence pre-filter
+    void testHasMatch_data();
+    void testHasMatch();
+    void testHasLoweredMatch();
+
+    // Score-only kernel
+    void testScoreOnlyMatchesFullMatrix_data();
+    void testScoreOnlyMatchesFullMatrix();
+
+    // Upper bound
+    void testMaxScoreBoundsScore_data();
+    void testMaxScoreBoundsScore();
+    void testMaxScoreEdgeCases();
+
+    // UTF-8 entry point
+    void testScoreUtf8MatchesScore_data();
+    void testScoreUtf8MatchesScore();
 };
 
 void FuzzyTest::testEmptyStrings()
@@ -549,5 +568,174 @@ void FuzzyTest::testBacktrackingWordBoundaryWins()
     QCOMPARE(positions[5], 12); // 'g'
 }
 
+void FuzzyTest::testHasMatch_data()
+{
+    QTest::addColumn<QString>("needle");
+    QTest::addColumn<QString>("haystack");
+    QTest::addColumn<bool>("expected");
+
+    // Long enough to cover full vector blocks and their scalar tails.
+    const QString longHaystack = QStringLiteral("QAbstractItemModel::beginInsertRows_and_endInsertRows");
+
+    QTest::newRow("empty needle") << QString() << QStringLiteral("abc") << true;
+    QTest::newRow("empty haystack") << QStringLiteral("a") << QString() << false;
+    QTest::newRow("subsequence") << QStringLiteral("qsa") << QStringLiteral("QString::arg") << true;
+    QTest::newRow("wrong order") << QStringLiteral("aqs") << QStringLiteral("QString::arg") << false;
+    QTest::newRow("case-insensitive") << QStringLiteral("QSTR") << QStringLiteral("qstring") << true;
+    QTest::newRow("long match") << QStringLiteral("qaimbirer") << longHaystack << true;
+    QTest::newRow("long match at tail") << QStringLiteral("qrows") << longHaystack << true;
+    QTest::newRow("long no match") << QStringLiteral("qaimz") << longHaystack << false;
+    QTest::newRow("repeated character") << QStringLiteral("rrr") << longHaystack << false;
+    QTest::newRow("symbols") << QStringLiteral("::_") << longHaystack << true;
+    QTest::newRow("non-ASCII needle") << QStringLiteral("überk") << QStringLiteral("Übersicht_Klasse") << true;
+    QTest::newRow("non-ASCII haystack") << QStringLiteral("ak") << QStringLiteral("Ärger_Katze") << true;
+    QTest::newRow("Kelvin sign lowers to k") << QStringLiteral("k") << QStringLiteral("1\u212A") << true;
+    QTest::newRow("CJK") << QStringLiteral("\u4e2d") << QStringLiteral("abc\u4e2ddef") << true;
+}
+
+void FuzzyTest::testHasMatch()
+{
+    QFETCH(QString, needle);
+    QFETCH(QString, haystack);
+    QFETCH(bool, expected);
+
+    QCOMPARE(hasMatch(needle, haystack), expected);
+
+    // Every kernel the CPU supports must agree with the scalar one.
+    for (const Detail::Kernel &kernel : Detail::supportedKernels()) {
+        QVERIFY2(Detail::hasMatch(kernel.find, needle, haystack) == expected, kernel.name);
+    }
+}
+
+void FuzzyTest::testHasLoweredMatch()
+{
+    const auto lowered = [](const QString &s) {
+        QString result;
+        for (const QChar ch : s) {
+            result.append(ch.toLower());
+        }
+        return result;
+    };
+
+    const QString haystack = lowered(QStringLiteral("QAbstractItemModel::beginInsertRows"));
+    for (const Detail::Kernel &kernel : Detail::supportedKernels()) {
+        QVERIFY2(Detail::hasLoweredMatch(kernel.find, QStringLiteral("qaimbir"), haystack), kernel.name);
+        QVERIFY2(!Detail::hasLoweredMatch(kernel.find, QStringLiteral("qaimbirz"), haystack), kernel.name);
+    }
+
+    QVERIFY(hasLoweredMatch(QStringLiteral("rows"), haystack));
+    QVERIFY(!hasLoweredMatch(QStringLiteral("ROWS"), haystack));
+}
+
+void FuzzyTest::testScoreOnlyMatchesFullMatrix_data()
+{
+    QTest::addColumn<QString>("needle");
+    QTest::addColumn<QString>("haystack");
+
+    QTest::newRow("prefix") << QStringLiteral("qstr") << QStringLiteral("QString");
+    QTest::newRow("camel case") << QStringLiteral("qaim") << QStringLiteral("QAbstractItemModel");
+    QTest::newRow("scope") << QStringLiteral("string") << QStringLiteral("str::to_string");
+    QTest::newRow("word boundary") << QStringLiteral("string") << QStringLiteral("Static String");
+    QTest::newRow("many gaps") << QStringLiteral("abc") << QStringLiteral("a_________b_________c");
+    QTest::newRow("no match") << QStringLiteral("xyz") << QStringLiteral("QString");
+    QTest::newRow("single character") << QStringLiteral("s") << QStringLiteral("std::sort");
+    QTest::newRow("path") << QStringLiteral("docset") << QStringLiteral("src/libs/registry/docset.cpp");
+}
+
+void FuzzyTest::testScoreOnlyMatchesFullMatrix()
+{
+    QFETCH(QString, needle);
+    QFETCH(QString, haystack);
+
+    // Score the longer haystack first, so stale rows from it are present
+    // when the shorter one is scored.
+    const QString longer = haystack + haystack;
+    QList<int> positions;
+    QCOMPARE(computeScore(needle, longer), computeScore(needle, longer, &positions));
+
+    // Bitwise equal: both paths must perform the same operations.
+    const double scoreOnly = computeScore(needle, haystack);
+    const double full = computeScore(needle, haystack, &positions);
+    QVERIFY(scoreOnly == full);
+}
+
+void FuzzyTest::testMaxScoreBoundsScore_data()
+{
+    QTest::addColumn<QString>("needle");
+    QTest::addColumn<QString>("haystack");
+
+    QTest::newRow("prefix") << QStringLiteral("qstr") << QStringLiteral("QString");
+    QTest::newRow("camel case") << QStringLiteral("qaim") << QStringLiteral("QAbstractItemModel");
+    QTest::newRow("scope") << QStringLiteral("string") << QStringLiteral("str::to_string");
+    QTest::newRow("after slash") << QStringLiteral("doc") << QStringLiteral("a/doc");
+    QTest::newRow("many gaps") << QStringLiteral("abc") << QStringLiteral("a_________b_________c");
+    QTest::newRow("single character") << QStringLiteral("s") << QStringLiteral("std::sort");
+    QTest::newRow("long") << QStringLiteral("a").repeated(500) << QStringLiteral("a").repeated(1000);
+}
+
+void FuzzyTest::testMaxScoreBoundsScore()
+{
+    QFETCH(QString, needle);
+    QFETCH(QString, haystack);
+
+    const double actual = computeScore(needle, haystack);
+    QVERIFY(actual > -std::numeric_limits<double>::infinity());
+    QVERIFY(actual <= maxScore(needle.size(), haystack.size()));
+}
+
+void FuzzyTest::testMaxScoreEdgeCases()
+{
+    const double inf = std::numeric_limits<double>::infinity();
+
+    QCOMPARE(maxScore(0, 5), -inf);
+    QCOMPARE(maxScore(6, 5), -inf);
+    QCOMPARE(maxScore(2, 1025), -inf);
+    QCOMPARE(maxScore(5, 5), inf);
+
+    // Tight for a prefix match: only the slack separates them.
+    const double bound = maxScore(4, 7);
+    const double actual = computeScore(QStringLiteral("qstr"), QStringLiteral("QString"));
+    QVERIFY(bound >= actual);
+    QVERIFY(bound - actual < 1e-6);
+}
+
+void FuzzyTest::testScoreUtf8MatchesScore_data()
+{
+    QTest::addColumn<QString>("needle");
+    QTest::addColumn<QString>("haystack");
+
+    QTest::newRow("ascii") << QStringLiteral("qaim") << QStringLiteral("QAbstractItemModel");
+    QTest::newRow("upper case needle") << QStringLiteral("QStr") << QStringLiteral("QString");
+    QTest::newRow("exact") << QStringLiteral("qstring") << QStringLiteral("QString");
+    QTest::newRow("no match") << QStringLiteral("xyz") << QStringLiteral("QString");
+    QTest::newRow("needle longer") << QStringLiteral("qstringlist") << QStringLiteral("QString");
+    QTest::newRow("empty haystack") << QStringLiteral("q") << QString();
+    QTest::newRow("non-ascii haystack") << QStringLiteral("uber") << QStringLiteral("Über::überall");
+    QTest::newRow("non-ascii needle") << QStringLiteral("Üb") << QStringLiteral("Über::überall");
+    QTest::newRow("cjk") << QStringLiteral("文字") << QStringLiteral("文字列::長さ");
+    QTest::newRow("too long ascii") << QStringLiteral("ab") << QStringLiteral("a").repeated(1100) + u'b';
+    // 600 two-byte characters are 1200 bytes but only 600 code units.
+    QTest::newRow("long non-ascii") << QStringLiteral("éb") << QStringLiteral("é").repeated(600) + u'b';
+}
+
+void FuzzyTest::testScoreUtf8MatchesScore()
+{
+    QFETCH(QString, needle);
+    QFETCH(QString, haystack);
+
+    QString lowerNeedle;
+    for (const QChar ch : needle) {
+        lowerNeedle.append(ch.toLower());
+    }
+
+    // Pad with trailing bytes, which must not be read.
+    const QByteArray utf8 = haystack.toUtf8();
+    const QByteArray padded = utf8 + "zzzz";
+
+    const double expected = score(needle, haystack);
+    const double actual = scoreUtf8(lowerNeedle, padded.constData(), utf8.size());
+    QVERIFY(actual == expected);
+}
+
 QTEST_MAIN(FuzzyTest)
 #include "fuzzy_test.moc"